@@ -7,6 +7,32 @@ exports.getDevices = function getDevices() {
   return addon.getDevices();
 };
 
+/**
+ * Per-stage timings of stream reading and processing, recorded on every
+ * thread once enabled. Stats are in microseconds; getChromeTrace() returns
+ * JSON for chrome://tracing or Perfetto.
+ */
+exports.profiler = {
+  enable() {
+    addon.profiler.enable();
+  },
+  disable() {
+    addon.profiler.disable();
+  },
+  isEnabled() {
+    return addon.profiler.isEnabled();
+  },
+  reset() {
+    addon.profiler.reset();
+  },
+  getStats() {
+    return addon.profiler.getStats();
+  },
+  getChromeTrace() {
+    return addon.profiler.getChromeTrace();
+  },
+};
+
 exports.InputStream = class InputStream {
   constructor(options) {
     this._wrapped = new addon.InputStream(options || {});
@@ -19,4 +45,39 @@ exports.InputStream = class InputStream {
   stop() {
     return this._wrapped.stop();
   }
+
+  getStats() {
+    return this._wrapped.getStats();
+  }
+
+  /**
+   * With `pull: true`, returns the newest frame (or null before the first
+   * one) instead of pushing every frame to a callback. The same object is
+   * reused; compare `frame.sequence` to tell frames apart.
+   */
+  readLatest() {
+    return this._wrapped.readLatest();
+  }
+};
+
+/**
+ * Captures one channel from each of `options.devices` and delivers them
+ * together, with every device resampled onto the first device's clock.
+ */
+exports.AggregateInputStream = class AggregateInputStream {
+  constructor(options) {
+    this._wrapped = new addon.AggregateInputStream(options || {});
+  }
+
+  start() {
+    return this._wrapped.start();
+  }
+
+  stop() {
+    return this._wrapped.stop();
+  }
+
+  getStats() {
+    return this._wrapped.getStats();
+  }
 };
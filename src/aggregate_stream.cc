@@ -0,0 +1,457 @@
+#include "aggregate_stream.h"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+#include "js_frame.h"
+#include "options.h"
+#include "pacheck.h"
+#include "processing_pool.h"
+#include "profiler.h"
+
+namespace rtaudio {
+namespace {
+
+void Terminate() {
+  PaError error = Pa_Terminate();
+  if (error != paNoError) {
+    std::cerr << "Pa_Terminate() failed: " << Pa_GetErrorText(error)
+              << std::endl;
+  }
+}
+
+// Relative deviation of `rate` from `reference_rate` in parts per million, or
+// 0 while either clock is still unmeasured.
+double GetDriftPpm(double rate, double reference_rate) {
+  if (rate <= 0 || reference_rate <= 0) {
+    return 0;
+  }
+  return (rate / reference_rate - 1) * 1e6;
+}
+
+}  // namespace
+
+Napi::Function AggregateInputStream::GetClass(Napi::Env env) {
+  return DefineClass(
+      env, "AggregateInputStream",
+      {
+          AggregateInputStream::InstanceMethod("start",
+                                               &AggregateInputStream::Start),
+          AggregateInputStream::InstanceMethod("stop",
+                                               &AggregateInputStream::Stop),
+          AggregateInputStream::InstanceMethod(
+              "getStats", &AggregateInputStream::GetStats),
+      });
+}
+
+AggregateInputStream::AggregateInputStream(const Napi::CallbackInfo& info)
+    : ObjectWrap(info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 1) {
+    NAPI_THROW(Napi::TypeError::New(env, "Missing options argument"));
+  }
+
+  if (!info[0].IsObject()) {
+    NAPI_THROW(Napi::TypeError::New(env, "options argument is not an object"));
+  }
+
+  const Napi::Object options = info[0].As<Napi::Object>();
+  const Napi::Value devices = options["devices"];
+  if (!devices.IsArray() || devices.As<Napi::Array>().Length() == 0) {
+    NAPI_THROW(
+        Napi::Error::New(env, std::string("Invalid value for devices: ") +
+                                  devices.ToString().Utf8Value()));
+  }
+  if (!ParseAudioProcessorOptions(env, options, &processor_options_)) {
+    return;
+  }
+  // Resampling works on float samples, so integer capture is not offered.
+  if (processor_options_.sample_format != SampleFormat::kFloat32) {
+    NAPI_THROW(Napi::Error::New(
+        env, "AggregateInputStream only supports the float32 sampleFormat"));
+  }
+  // Trigger events are delivered through InputStream's onTrigger callback,
+  // which the aggregate stream does not have.
+  if (!processor_options_.triggers.empty()) {
+    NAPI_THROW(Napi::Error::New(
+        env, "AggregateInputStream does not support triggers"));
+  }
+  if (const Napi::Value value = options["callback"]; !value.IsUndefined()) {
+    if (!value.IsFunction()) {
+      NAPI_THROW(
+          Napi::Error::New(env, std::string("Invalid value for callback: ") +
+                                    value.ToString().Utf8Value()));
+    }
+    callback_ = Napi::Persistent(value.As<Napi::Function>());
+  }
+
+  const Napi::Array device_indices = devices.As<Napi::Array>();
+  Napi::Object frame = Napi::Object::New(env);
+  frame["sampleRate"] = Napi::Number::New(env, processor_options_.sample_rate);
+  Napi::Array channels = Napi::Array::New(env, device_indices.Length());
+  for (uint32_t i = 0; i < device_indices.Length(); ++i) {
+    const Napi::Value value = device_indices.Get(i);
+    if (!value.IsNumber()) {
+      NAPI_THROW(
+          Napi::Error::New(env, std::string("Invalid value for devices: ") +
+                                    devices.ToString().Utf8Value()));
+    }
+    auto device = std::make_unique<Device>();
+    device->index = value.ToNumber().Int32Value();
+    device->frame =
+        std::unique_ptr<AudioFrame>(new AudioFrame(processor_options_));
+    device->processor = CreateAudioProcessor(processor_options_);
+    if (i > 0) {
+      device->block.resize(processor_options_.buffer_size);
+    }
+    Napi::Object channel =
+        NewJsFrame(env, processor_options_, *device->frame);
+    channel["device"] = Napi::Number::New(env, device->index);
+    channels[i] = channel;
+    devices_.push_back(std::move(device));
+  }
+  frame["channels"] = channels;
+  js_frame_ = Napi::Persistent(frame);
+}
+
+AggregateInputStream::~AggregateInputStream() {
+  if (running_) {
+    std::cerr
+        << "~AggregateInputStream() destructor called while still running."
+        << std::endl;
+    tsfn_.Abort();
+    Terminate();
+  }
+  running_ = false;
+  if (devices_[0]->reader_thread.joinable()) {
+    devices_[0]->reader_thread.join();
+  }
+}
+
+void AggregateInputStream::Start(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (devices_[0]->stream) {
+    NAPI_THROW(Napi::Error::New(env, "Stream already initialized"));
+  }
+
+  PA_CHECK(Pa_Initialize());
+
+  struct Cleanup {
+    AggregateInputStream* stream;
+    bool success = false;
+    ~Cleanup() {
+      if (!success) {
+        for (auto& device : stream->devices_) {
+          device->stream = nullptr;
+        }
+        Terminate();
+      }
+    }
+  } cleanup{this};
+
+  for (auto& device : devices_) {
+    const PaDeviceInfo* const inputInfo = Pa_GetDeviceInfo(device->index);
+    if (!inputInfo) {
+      NAPI_THROW(Napi::Error::New(env, std::string("Invalid device index: ") +
+                                           std::to_string(device->index)));
+    }
+    if (inputInfo->maxInputChannels == 0) {
+      NAPI_THROW(Napi::Error::New(
+          env, std::string("Not an input device: ") + inputInfo->name));
+    }
+    const PaStreamParameters inputParameters{
+        .device = device->index,
+        .channelCount = 1,
+        .sampleFormat = paFloat32,
+        .suggestedLatency = inputInfo->defaultLowInputLatency,
+    };
+    PA_CHECK(Pa_OpenStream(&device->stream, &inputParameters, nullptr,
+                           processor_options_.sample_rate,
+                           processor_options_.buffer_size, paNoFlag, nullptr,
+                           nullptr));
+  }
+  for (auto& device : devices_) {
+    PA_CHECK(Pa_StartStream(device->stream));
+  }
+
+  static const char kResourceName[] = "Aggregate Audio Frame Callback";
+  static constexpr size_t kMaxQueueSize = 1;
+  static constexpr size_t kInitialThreadCount = 1;
+  if (!callback_.IsEmpty()) {
+    tsfn_ = TSFN::New(env, callback_.Value().As<Napi::Function>(),
+                      kResourceName, kMaxQueueSize, kInitialThreadCount, this);
+  } else {
+    tsfn_ =
+        TSFN::New(env, kResourceName, kMaxQueueSize, kInitialThreadCount, this);
+  }
+
+  frame_count_ = 0;
+  failed_ = false;
+  error_ = std::nullopt;
+  reference_clock_ = std::make_unique<ClockEstimator>();
+  for (size_t i = 1; i < devices_.size(); ++i) {
+    devices_[i]->compensator =
+        std::make_unique<DriftCompensator>(processor_options_.buffer_size);
+  }
+  running_.store(true);
+  for (size_t i = 1; i < devices_.size(); ++i) {
+    Device* const device = devices_[i].get();
+    device->reader_thread = std::thread([this, device] {
+      ReadSecondary(device);
+    });
+  }
+  devices_[0]->reader_thread =
+      std::thread([this, js_this = Napi::Persistent(info.This())] {
+        ReadReference();
+      });
+  cleanup.success = true;
+}
+
+void AggregateInputStream::Fail(const std::string& message) {
+  std::lock_guard<std::mutex> lock(error_mutex_);
+  if (!error_) {
+    error_ = message;
+  }
+  failed_.store(true);
+}
+
+bool AggregateInputStream::WaitForInput(const Device& device) {
+  // Reads only start once input is available, so Pa_ReadStream never blocks
+  // for longer than one buffer and Stop() cannot hang on a stalled device.
+  const auto poll_interval = std::chrono::duration<double>(
+      processor_options_.buffer_size / processor_options_.sample_rate / 4);
+  const auto start_time = std::chrono::steady_clock::now();
+  while (running_.load() && !failed_.load()) {
+    const signed long available = Pa_GetStreamReadAvailable(device.stream);
+    if (available < 0) {
+      const PaError status = available;
+      std::ostringstream message;
+      message << "Error reading device " << device.index << ": "
+              << Pa_GetErrorText(status);
+      Fail(message.str());
+      return false;
+    }
+    if (available > 0) {
+      return true;
+    }
+    if (std::chrono::steady_clock::now() - start_time >
+        std::chrono::seconds(1)) {
+      Fail("Timeout: over 1s waiting for audio from device " +
+           std::to_string(device.index));
+      return false;
+    }
+    std::this_thread::sleep_for(poll_interval);
+  }
+  return false;
+}
+
+void AggregateInputStream::ReadSecondary(Device* device) {
+  Profiler::SetThreadName("AggregateInputStream secondary reader");
+  while (WaitForInput(*device)) {
+    PaError status;
+    {
+      ScopedTrace trace("read");
+      status = Pa_ReadStream(device->stream, device->block.data(),
+                             processor_options_.buffer_size);
+    }
+    if (status == paInputOverflowed) {
+      device->overflow_count.fetch_add(1, std::memory_order_relaxed);
+    } else if (status != paNoError) {
+      std::ostringstream message;
+      message << "Error reading device " << device->index << ": "
+              << Pa_GetErrorText(status);
+      Fail(message.str());
+      break;
+    }
+    device->compensator->Push(device->block.data(), device->block.size(),
+                              Pa_GetStreamTime(device->stream));
+  }
+}
+
+void AggregateInputStream::ReadReference() {
+  Device* const reference = devices_[0].get();
+  ProcessingPool& pool = ProcessingPool::Shared();
+  const std::function<void(size_t)> process = [this](size_t i) {
+    devices_[i]->processor->Process(devices_[i]->frame.get());
+  };
+  std::vector<uint64_t> last_overflows(devices_.size(), 0);
+  Profiler::SetThreadName("AggregateInputStream reference reader");
+  // Any pool thread may process any channel, so every one of them sizes its
+  // per-thread scratch for the processors before capture starts.
+  pool.RunOnEveryThread([this] {
+    for (const auto& device : devices_) {
+      device->processor->Prepare();
+    }
+  });
+  while (WaitForInput(*reference)) {
+    PaError status;
+    {
+      ScopedTrace trace("read");
+      status =
+          Pa_ReadStream(reference->stream, reference->frame->samples.data(),
+                        processor_options_.buffer_size);
+    }
+    reference->overflowed = false;
+    if (status == paInputOverflowed) {
+      reference->overflowed = true;
+      reference->overflow_count.fetch_add(1, std::memory_order_relaxed);
+      std::cerr << "Input overflowed: " << Pa_GetErrorText(status)
+                << std::endl;
+    } else if (status != paNoError) {
+      std::ostringstream message;
+      message << "Error reading device " << reference->index << ": "
+              << Pa_GetErrorText(status);
+      Fail(message.str());
+    }
+    if (failed_.load()) {
+      break;
+    }
+    reference_clock_->Update(processor_options_.buffer_size,
+                             Pa_GetStreamTime(reference->stream));
+    for (size_t i = 1; i < devices_.size(); ++i) {
+      Device* const device = devices_[i].get();
+      device->compensator->Pull(device->frame->samples.data(),
+                                processor_options_.buffer_size,
+                                reference_clock_->rate());
+      const uint64_t overflows = device->overflow_count.load() +
+                                 device->compensator->overflows();
+      device->overflowed = overflows != last_overflows[i];
+      last_overflows[i] = overflows;
+    }
+    for (auto& device : devices_) {
+      device->frame->start_sample =
+          frame_count_.load(std::memory_order_relaxed) *
+          processor_options_.buffer_size;
+    }
+    pool.Run(devices_.size(), process);
+    frame_count_.fetch_add(1, std::memory_order_relaxed);
+    ScopedTrace trace("BlockingCall");
+    tsfn_.BlockingCall();
+  }
+  const bool failed = failed_.load();
+  if (failed) {
+    std::string* error = [this] {
+      std::lock_guard<std::mutex> lock(error_mutex_);
+      return new std::string(error_.value_or("Unknown error"));
+    }();
+    if (tsfn_.BlockingCall(error) != napi_ok) {
+      delete error;
+    }
+  }
+  // The secondary readers are owned by this thread, so that Stop() only has
+  // to join one thread and an error can shut everything down from here.
+  running_ = false;
+  for (size_t i = 1; i < devices_.size(); ++i) {
+    if (devices_[i]->reader_thread.joinable()) {
+      devices_[i]->reader_thread.join();
+    }
+  }
+  tsfn_.Release();
+  if (failed) {
+    Terminate();
+  }
+}
+
+Napi::Value AggregateInputStream::GetStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Object stats = Napi::Object::New(env);
+  stats["frames"] =
+      Napi::Number::New(env, static_cast<double>(frame_count_.load()));
+  stats["sampleRate"] = Napi::Number::New(env, processor_options_.sample_rate);
+  stats["bufferSize"] =
+      Napi::Number::New(env, processor_options_.buffer_size);
+  stats["poolThreads"] = Napi::Number::New(
+      env, static_cast<double>(ProcessingPool::Shared().thread_count()));
+  const double reference_rate =
+      reference_clock_ ? reference_clock_->rate() : 0;
+  Napi::Array devices = Napi::Array::New(env, devices_.size());
+  for (size_t i = 0; i < devices_.size(); ++i) {
+    const Device& device = *devices_[i];
+    Napi::Object js_device = Napi::Object::New(env);
+    js_device["device"] = Napi::Number::New(env, device.index);
+    js_device["overflows"] = Napi::Number::New(
+        env, static_cast<double>(device.overflow_count.load()));
+    if (i == 0) {
+      js_device["rate"] = Napi::Number::New(env, reference_rate);
+    } else if (device.compensator) {
+      const DriftCompensator& compensator = *device.compensator;
+      js_device["rate"] = Napi::Number::New(env, compensator.rate());
+      js_device["driftPpm"] = Napi::Number::New(
+          env, GetDriftPpm(compensator.rate(), reference_rate));
+      js_device["ratio"] = Napi::Number::New(env, compensator.ratio());
+      js_device["underruns"] = Napi::Number::New(
+          env, static_cast<double>(compensator.underruns()));
+      js_device["droppedBlocks"] = Napi::Number::New(
+          env, static_cast<double>(compensator.overflows()));
+    }
+    devices[i] = js_device;
+  }
+  stats["devices"] = devices;
+  return stats;
+}
+
+void AggregateInputStream::UpdateJsFrame(Napi::Env env) {
+  ScopedTrace trace("UpdateJsFrame");
+  Napi::Object frame = js_frame_.Value();
+  Napi::Array channels = frame.Get("channels").As<Napi::Array>();
+  const double reference_rate = reference_clock_->rate();
+  for (size_t i = 0; i < devices_.size(); ++i) {
+    const Device& device = *devices_[i];
+    Napi::Object channel = channels.Get(i).As<Napi::Object>();
+    channel["overflowed"] = Napi::Boolean::New(env, device.overflowed);
+    channel["driftPpm"] = Napi::Number::New(
+        env, i == 0 ? 0
+                    : GetDriftPpm(device.compensator->rate(), reference_rate));
+    rtaudio::UpdateJsFrame(env, processor_options_, *device.frame, channel);
+  }
+}
+
+void AggregateInputStream::CallJs(Napi::Env env, Napi::Function callback,
+                                  AggregateInputStream* stream,
+                                  std::string* data) {
+  const std::unique_ptr<std::string> error(data);
+  if (env == nullptr || callback == nullptr) {
+    return;
+  }
+  ScopedTrace trace("CallJs");
+  if (!error) {
+    stream->UpdateJsFrame(env);
+    Napi::Object frame = stream->js_frame_.Value();
+    callback.Call({env.Undefined(), frame});
+  } else {
+    callback.Call({Napi::Error::New(env, *error).Value(), env.Undefined()});
+  }
+}
+
+void AggregateInputStream::Stop(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (!devices_[0]->stream) {
+    NAPI_THROW(Napi::Error::New(env, "Stream not initialized"));
+  }
+
+  if (!running_.load()) {
+    NAPI_THROW(Napi::Error::New(env, "Reader thread never started"));
+  }
+
+  if (!devices_[0]->reader_thread.joinable()) {
+    NAPI_THROW(Napi::Error::New(env, "Reader thread not running"));
+  }
+  tsfn_.Abort();
+
+  running_.store(false);
+  devices_[0]->reader_thread.join();
+  devices_[0]->reader_thread = std::thread();
+
+  for (auto& device : devices_) {
+    PA_CHECK(Pa_StopStream(device->stream));
+    device->stream = nullptr;
+  }
+  Terminate();
+}
+
+}  // namespace rtaudio
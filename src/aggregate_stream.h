@@ -0,0 +1,86 @@
+#ifndef AGGREGATE_STREAM_H
+#define AGGREGATE_STREAM_H
+
+#include <napi.h>
+#include <portaudio.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio.h"
+#include "drift.h"
+
+namespace rtaudio {
+
+// Captures one channel from each of several devices and delivers them as a
+// single frame on the first device's timeline. The other devices are
+// resampled to follow the first device's clock, and all channels are
+// processed on the shared ProcessingPool.
+class AggregateInputStream : public Napi::ObjectWrap<AggregateInputStream> {
+ public:
+  static Napi::Function GetClass(Napi::Env);
+  AggregateInputStream(const Napi::CallbackInfo&);
+  ~AggregateInputStream();
+
+  void Start(const Napi::CallbackInfo&);
+
+  void Stop(const Napi::CallbackInfo&);
+
+  Napi::Value GetStats(const Napi::CallbackInfo&);
+
+ private:
+  struct Device {
+    int index;
+    PaStream* stream = nullptr;
+    std::unique_ptr<AudioFrame> frame;
+    std::unique_ptr<AudioProcessor> processor;
+    // Secondary devices only.
+    std::unique_ptr<DriftCompensator> compensator;
+    std::vector<float> block;
+    std::thread reader_thread;
+    bool overflowed = false;
+    std::atomic<uint64_t> overflow_count{0};
+  };
+
+  // `data` is null for frame calls. After a failure the reference reader
+  // makes one final call that passes an owned error message.
+  static void CallJs(Napi::Env env, Napi::Function callback,
+                     AggregateInputStream* stream, std::string* data);
+  void UpdateJsFrame(Napi::Env env);
+  void ReadReference();
+  void ReadSecondary(Device* device);
+  // Polls `device` until input is available. Returns false once the stream
+  // stops or fails, including after a second without any input.
+  bool WaitForInput(const Device& device);
+  void Fail(const std::string& message);
+  void StopDevices();
+
+  AudioProcessorOptions processor_options_;
+  std::vector<std::unique_ptr<Device>> devices_;
+  std::atomic<bool> running_{false};
+  std::unique_ptr<ClockEstimator> reference_clock_;
+  std::atomic<uint64_t> frame_count_{0};
+
+  using TSFN =
+      Napi::TypedThreadSafeFunction<AggregateInputStream, std::string, CallJs>;
+
+  TSFN tsfn_;
+  Napi::FunctionReference callback_;
+  // Set by Fail() from any reader thread and checked by the reference reader
+  // after every read.
+  std::atomic<bool> failed_{false};
+  std::mutex error_mutex_;
+  std::optional<std::string> error_;
+  Napi::Reference<Napi::Object> js_frame_;
+};
+
+}  // namespace rtaudio
+
+#endif  // AGGREGATE_STREAM_H
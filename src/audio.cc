@@ -1,15 +1,43 @@
 #include "audio.h"
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstring>
+#include <iterator>
 #include <functional>
 #include <optional>
+#include <utility>
 
 #include "Iir.h"
 #include "fft.h"
+#include "profiler.h"
 
 namespace rtaudio {
 namespace {
 
+// Follower time constants shared by every smoothed feature.
+constexpr float kTauSlow = 15;  // 15 seconds.
+constexpr float kTauMid = .75;  // 750 milliseconds.
+constexpr float kTauFast = .1;  // 100 milliseconds.
+
+bool NeedsMagnitude(const AudioProcessorOptions& options) {
+  return (options.magnitude_spectrum && options.full_resolution) ||
+         options.spectral_descriptors ||
+         (options.display_bins > 0 && !options.db_spectrum);
+}
+
+// The power spectrum is only ever exported.
+bool NeedsPower(const AudioProcessorOptions& options) {
+  return options.power_spectrum && options.full_resolution;
+}
+
+// The dB spectrum is exported and may feed the display spectrum.
+bool NeedsDecibels(const AudioProcessorOptions& options) {
+  return options.db_spectrum &&
+         (options.full_resolution || options.display_bins > 0);
+}
+
 float TauToAlpha(float sample_rate, float tau_seconds) {
   return 1.0 - std::exp(-1.0 / (sample_rate * tau_seconds));
 }
@@ -63,33 +91,212 @@ float GetPeak(const std::vector<float>& samples) {
   return peak;
 }
 
+// Number of independent accumulators per reduction. Float addition is not
+// associative, so without -ffast-math a single running sum cannot be split
+// across vector lanes; accumulating into kLanes separate sums makes the lane
+// split explicit, and GCC and Clang turn each group of lanes into packed
+// operations.
+constexpr size_t kLanes = 8;
+
+// |x| as an integer. For non-NaN floats the ordering of these bit patterns
+// matches the ordering of the absolute values, and unlike a float max an
+// integer max vectorises without -ffinite-math-only.
+inline uint32_t AbsBits(float x) {
+  uint32_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  return bits & 0x7fffffff;
+}
+
+// `x` as an integer with the same ordering as the float for non-NaN values:
+// negative values have their magnitude bits flipped. The mapping is its own
+// inverse, and integer min/max over it vectorises where the float ones don't.
+inline int32_t OrderedBits(float x) {
+  int32_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  return bits ^ ((bits >> 31) & 0x7fffffff);
+}
+
+inline float FromOrderedBits(int32_t bits) {
+  bits ^= (bits >> 31) & 0x7fffffff;
+  float x;
+  std::memcpy(&x, &bits, sizeof(x));
+  return x;
+}
+
+// Returns the RMS and peak of `size` samples.
+std::pair<float, float> Measure(const float* samples, size_t size) {
+  if (size == 0) {
+    return {0, 0};
+  }
+  float sums[kLanes] = {};
+  uint32_t peaks[kLanes] = {};
+  size_t i = 0;
+  for (; i + kLanes <= size; i += kLanes) {
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      const float sample = samples[i + lane];
+      sums[lane] += sample * sample;
+      peaks[lane] = std::max(peaks[lane], AbsBits(sample));
+    }
+  }
+  for (; i < size; ++i) {
+    sums[0] += samples[i] * samples[i];
+    peaks[0] = std::max(peaks[0], AbsBits(samples[i]));
+  }
+  float sum = 0;
+  uint32_t peak_bits = 0;
+  for (size_t lane = 0; lane < kLanes; ++lane) {
+    sum += sums[lane];
+    peak_bits = std::max(peak_bits, peaks[lane]);
+  }
+  float peak;
+  std::memcpy(&peak, &peak_bits, sizeof(peak));
+  return {std::sqrt(sum / size), peak};
+}
+
+void ConvertInt16(const int16_t* __restrict input, size_t size,
+                  float* __restrict output) {
+  static constexpr float kScale = 1.f / 32768;
+  for (size_t i = 0; i < size; ++i) {
+    output[i] = input[i] * kScale;
+  }
+}
+
+// Packed little-endian 24-bit samples. Placing the three bytes in the top of
+// a 32-bit word sign-extends them for free. Four samples are unpacked from
+// three whole words at a time, which lets the conversion and scaling run as
+// packed operations.
+void ConvertInt24(const uint8_t* __restrict input, size_t size,
+                  float* __restrict output) {
+  static constexpr float kScale = 1.f / 2147483648.f;
+  static constexpr uint32_t kMask = 0xffffff00;
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    uint32_t words[3];
+    std::memcpy(&words[0], input + 3 * i, sizeof(uint32_t));
+    std::memcpy(&words[1], input + 3 * i + 4, sizeof(uint32_t));
+    std::memcpy(&words[2], input + 3 * i + 8, sizeof(uint32_t));
+    output[i] = static_cast<int32_t>(words[0] << 8) * kScale;
+    output[i + 1] =
+        static_cast<int32_t>((words[0] >> 16 | words[1] << 16) & kMask) *
+        kScale;
+    output[i + 2] =
+        static_cast<int32_t>((words[1] >> 8 | words[2] << 24) & kMask) *
+        kScale;
+    output[i + 3] = static_cast<int32_t>(words[2] & kMask) * kScale;
+  }
+  for (; i < size; ++i) {
+    const uint8_t* bytes = input + 3 * i;
+    const uint32_t word = (uint32_t(bytes[0]) << 8) |
+                          (uint32_t(bytes[1]) << 16) |
+                          (uint32_t(bytes[2]) << 24);
+    output[i] = static_cast<int32_t>(word) * kScale;
+  }
+}
+
+// First stage of the chain. Converts integer device samples into
+// `frame->samples` (which the FFT and band filters read directly), then
+// measures the full-band RMS and peak in a separate pass while the samples
+// are still in L1. Each loop vectorises on its own; fused, neither did.
+class InputProcessor final : public AudioProcessor {
+ public:
+  explicit InputProcessor(SampleFormat sample_format)
+      : sample_format_(sample_format) {}
+
+  void Process(AudioFrame* frame) final {
+    const size_t size = frame->samples.size();
+    float* const samples = frame->samples.data();
+    switch (sample_format_) {
+      case SampleFormat::kFloat32:
+        break;
+      case SampleFormat::kInt16:
+        ConvertInt16(reinterpret_cast<const int16_t*>(frame->input.data()),
+                     size, samples);
+        break;
+      case SampleFormat::kInt24:
+        ConvertInt24(frame->input.data(), size, samples);
+        break;
+    }
+    // Still in L1 after the conversion.
+    const std::pair<float, float> levels = Measure(samples, size);
+    frame->rms = levels.first;
+    frame->peak = levels.second;
+  }
+
+  void VisitBuffers(const BufferVisitor& visit) const final {
+    visit(this, sizeof(*this));
+  }
+
+ private:
+  const SampleFormat sample_format_;
+};
+
+// Runs named stages in order, timing each one under its name when profiling
+// is enabled.
 class CompositeProcessor final : public AudioProcessor {
  public:
-  explicit CompositeProcessor(
-      std::vector<std::unique_ptr<AudioProcessor>> processors)
-      : processors_(std::move(processors)) {}
+  using Stage = std::pair<const char*, std::unique_ptr<AudioProcessor>>;
+
+  explicit CompositeProcessor(std::vector<Stage> stages)
+      : stages_(std::move(stages)) {}
 
   void Process(AudioFrame* frame) final {
-    for (auto& processor : processors_) {
+    for (auto& [name, processor] : stages_) {
+      ScopedTrace trace(name);
       processor->Process(frame);
     }
   };
 
+  void Prepare() final {
+    for (auto& [name, processor] : stages_) {
+      processor->Prepare();
+    }
+  }
+
+  void VisitBuffers(const BufferVisitor& visit) const final {
+    visit(this, sizeof(*this));
+    visit(stages_.data(), stages_.size() * sizeof(stages_[0]));
+    for (const auto& [name, processor] : stages_) {
+      processor->VisitBuffers(visit);
+    }
+  }
+
  private:
-  std::vector<std::unique_ptr<AudioProcessor>> processors_;
+  std::vector<Stage> stages_;
 };
 
 class FFTProcessor final : public AudioProcessor {
  public:
-  explicit FFTProcessor(size_t buffer_size) : real_fft_(buffer_size) {}
+  explicit FFTProcessor(const AudioProcessorOptions& options)
+      : real_fft_(options.buffer_size),
+        magnitude_(NeedsMagnitude(options)),
+        power_(NeedsPower(options)),
+        decibels_(NeedsDecibels(options)),
+        db_floor_(options.db_floor) {}
   void Process(AudioFrame* frame) final {
     // FFT
     real_fft_.ForwardTransform(frame->samples, &frame->fft);
-    RealFFT::GetAbsolute(frame->fft, &frame->absolute_fft);
+    if (magnitude_) {
+      RealFFT::GetAbsolute(frame->fft, &frame->absolute_fft);
+    }
+    if (power_ || decibels_) {
+      RealFFT::GetPower(frame->fft, power_ ? &frame->power_fft : nullptr,
+                        decibels_ ? &frame->db_fft : nullptr, db_floor_);
+    }
   };
 
+  void Prepare() final { real_fft_.Prepare(); }
+
+  void VisitBuffers(const BufferVisitor& visit) const final {
+    visit(this, sizeof(*this));
+    real_fft_.VisitBuffers(visit);
+  }
+
  private:
   RealFFT real_fft_;
+  const bool magnitude_;
+  const bool power_;
+  const bool decibels_;
+  const float db_floor_;
 };
 
 class BandProcessor final : public AudioProcessor {
@@ -112,19 +319,113 @@ class BandProcessor final : public AudioProcessor {
     }
   };
 
+  // The filter state lives inline in the processor.
+  void VisitBuffers(const BufferVisitor& visit) const final {
+    visit(this, sizeof(*this));
+  }
+
  private:
   Iir::Butterworth::LowPass<4> bass_filter_;
   Iir::Butterworth::BandPass<4> mid_filter_;
   Iir::Butterworth::HighPass<4> high_filter_;
 };
 
+// Follows each trigger's source sample by sample, so that crossings are
+// timed to the sample instead of to the buffer.
+class TriggerProcessor final : public AudioProcessor {
+ public:
+  explicit TriggerProcessor(const AudioProcessorOptions& options,
+                            TriggerEventSink on_trigger_events)
+      : on_trigger_events_(std::move(on_trigger_events)) {
+    for (const TriggerOptions& trigger : options.triggers) {
+      triggers_.push_back({
+          GetBand(trigger.source),
+          trigger.threshold,
+          trigger.threshold - trigger.hysteresis,
+          TauToAlpha(options.sample_rate, trigger.attack),
+          TauToAlpha(options.sample_rate, trigger.release),
+      });
+    }
+  }
+
+  void Process(AudioFrame* frame) final {
+    const size_t size = frame->samples.size();
+    frame->trigger_event_count = 0;
+    frame->dropped_trigger_events = 0;
+    for (size_t index = 0; index < triggers_.size(); ++index) {
+      Trigger& trigger = triggers_[index];
+      const float* const samples = trigger.band
+                                       ? (frame->*trigger.band).samples.data()
+                                       : frame->samples.data();
+      float envelope = trigger.envelope;
+      for (size_t i = 0; i < size; ++i) {
+        const float value = std::abs(samples[i]);
+        envelope += (value > envelope ? trigger.attack : trigger.release) *
+                    (value - envelope);
+        if (trigger.on ? envelope < trigger.off_threshold
+                       : envelope >= trigger.on_threshold) {
+          trigger.on = !trigger.on;
+          if (frame->trigger_event_count < frame->trigger_events.size()) {
+            frame->trigger_events[frame->trigger_event_count++] = {
+                static_cast<uint32_t>(index), trigger.on,
+                frame->start_sample + i, envelope};
+          } else {
+            ++frame->dropped_trigger_events;
+          }
+        }
+      }
+      trigger.envelope = envelope;
+    }
+    // Each trigger's events are already in order; merge them across triggers.
+    std::sort(frame->trigger_events.begin(),
+              frame->trigger_events.begin() + frame->trigger_event_count,
+              [](const TriggerEvent& a, const TriggerEvent& b) {
+                return a.sample < b.sample;
+              });
+    if (on_trigger_events_) {
+      on_trigger_events_(*frame);
+    }
+  }
+
+  void VisitBuffers(const BufferVisitor& visit) const final {
+    visit(this, sizeof(*this));
+    visit(triggers_.data(), triggers_.size() * sizeof(triggers_[0]));
+  }
+
+ private:
+  struct Trigger {
+    AudioFrame::Band AudioFrame::*band;
+    float on_threshold;
+    float off_threshold;
+    float attack;
+    float release;
+    float envelope = 0;
+    bool on = false;
+  };
+
+  // The followed band, or null for the full-band samples.
+  static AudioFrame::Band AudioFrame::*GetBand(TriggerSource source) {
+    switch (source) {
+      case TriggerSource::kFull:
+        return nullptr;
+      case TriggerSource::kBass:
+        return &AudioFrame::bass;
+      case TriggerSource::kMid:
+        return &AudioFrame::mid;
+      case TriggerSource::kHigh:
+        return &AudioFrame::high;
+    }
+    return nullptr;
+  }
+
+  const TriggerEventSink on_trigger_events_;
+  std::vector<Trigger> triggers_;
+};
+
 class PeakProcessor final : public AudioProcessor {
  public:
   explicit PeakProcessor(size_t buffer_size, float sample_rate) {
     const float sr = sample_rate / buffer_size;  // Follower sample rate.
-    static const float kTauSlow = 15;            // 15 seconds.
-    static const float kTauMid = .75;            // 750 milliseconds.
-    static const float kTauFast = .1;            // 100 milliseconds.
     using Mode = ExpDecayFollower::Mode;
     followers_.emplace_back(
         [](const AudioFrame* frame) { return frame->rms; },
@@ -204,8 +505,7 @@ class PeakProcessor final : public AudioProcessor {
   }
 
   void Process(AudioFrame* frame) final {
-    frame->rms = GetRms(frame->samples);
-    frame->peak = GetPeak(frame->samples);
+    // The full-band levels were already measured by InputProcessor.
     for (AudioFrame::Band* band : {&frame->bass, &frame->mid, &frame->high}) {
       band->rms = GetRms(band->samples);
       band->peak = GetPeak(band->samples);
@@ -216,6 +516,11 @@ class PeakProcessor final : public AudioProcessor {
     }
   }
 
+  void VisitBuffers(const BufferVisitor& visit) const final {
+    visit(this, sizeof(*this));
+    visit(followers_.data(), followers_.size() * sizeof(followers_[0]));
+  }
+
  private:
   using Getter = std::function<float(const AudioFrame*)>;
   using Setter = std::function<void(AudioFrame*, float value)>;
@@ -223,6 +528,407 @@ class PeakProcessor final : public AudioProcessor {
   std::vector<std::tuple<Getter, Setter, ExpDecayFollower>> followers_;
 };
 
+// Computes centroid, spread, rolloff, flatness, flux and crest of
+// `absolute_fft` in one pass, and smooths each with slow/mid/fast followers.
+class SpectralProcessor final : public AudioProcessor {
+ public:
+  explicit SpectralProcessor(size_t buffer_size, float sample_rate)
+      : sample_rate_(sample_rate),
+        previous_(RealFFT::GetTransformSize(buffer_size) / 2 + 1, 0) {
+    const float sr = sample_rate / buffer_size;  // Follower sample rate.
+    using Mode = ExpDecayFollower::Mode;
+    for (size_t i = 0; i < std::size(kDescriptors); ++i) {
+      followers_.push_back({
+          ExpDecayFollower(sr, kTauSlow, Mode::kAvg),
+          ExpDecayFollower(sr, kTauMid, Mode::kAvg),
+          ExpDecayFollower(sr, kTauFast, Mode::kAvg),
+      });
+    }
+  }
+
+  void Process(AudioFrame* frame) final {
+    static constexpr float kRolloff = .85;
+    static constexpr float kEpsilon = 1e-12;
+    const float* const magnitude = frame->absolute_fft.data();
+    float* const previous = previous_.data();
+    const size_t bins = previous_.size();
+    const float bin_hz = sample_rate_ / (2 * (bins - 1));
+
+    float sums[kLanes] = {};
+    float moments[kLanes] = {};
+    float moments2[kLanes] = {};
+    float powers[kLanes] = {};
+    float log_powers[kLanes] = {};
+    float fluxes[kLanes] = {};
+    uint32_t peaks[kLanes] = {};  // Magnitudes are never negative.
+    const auto accumulate = [&](size_t lane, size_t i) {
+      const float value = magnitude[i];
+      const float frequency = static_cast<int32_t>(i) * bin_hz;
+      const float power = value * value;
+      // max(change, 0) without the branch std::max compiles to here, which
+      // would keep the loop scalar.
+      const float change = value - previous[i];
+      const float rise = .5f * (change + std::abs(change));
+      previous[i] = value;
+      sums[lane] += value;
+      moments[lane] += value * frequency;
+      moments2[lane] += value * frequency * frequency;
+      powers[lane] += power;
+      log_powers[lane] += FastLog2(power + kEpsilon);
+      fluxes[lane] += rise * rise;
+      peaks[lane] = std::max(peaks[lane], AbsBits(value));
+    };
+    size_t i = 0;
+    for (; i + kLanes <= bins; i += kLanes) {
+      for (size_t lane = 0; lane < kLanes; ++lane) {
+        accumulate(lane, i + lane);
+      }
+    }
+    for (; i < bins; ++i) {
+      accumulate(0, i);
+    }
+    float sum = 0, moment = 0, moment2 = 0, power = 0, log_power = 0, flux = 0;
+    uint32_t peak_bits = 0;
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      sum += sums[lane];
+      moment += moments[lane];
+      moment2 += moments2[lane];
+      power += powers[lane];
+      log_power += log_powers[lane];
+      flux += fluxes[lane];
+      peak_bits = std::max(peak_bits, peaks[lane]);
+    }
+    float peak;
+    std::memcpy(&peak, &peak_bits, sizeof(peak));
+
+    if (sum > 0) {
+      const float centroid = moment / sum;
+      frame->spectral_centroid = centroid;
+      frame->spectral_spread =
+          std::sqrt(std::max(moment2 / sum - centroid * centroid, 0.f));
+      frame->spectral_rolloff =
+          GetRolloff(magnitude, bins, kRolloff * sum) * bin_hz;
+      frame->spectral_flatness =
+          std::exp2(log_power / bins) / (power / bins + kEpsilon);
+      frame->spectral_crest = peak / (sum / bins);
+    } else {
+      frame->spectral_centroid = 0;
+      frame->spectral_spread = 0;
+      frame->spectral_rolloff = 0;
+      frame->spectral_flatness = 0;
+      frame->spectral_crest = 0;
+    }
+    frame->spectral_flux = std::sqrt(flux);
+
+    for (size_t i = 0; i < std::size(kDescriptors); ++i) {
+      const Descriptor& descriptor = kDescriptors[i];
+      const float value = frame->*descriptor.value;
+      frame->*descriptor.slow = followers_[i][0].update(value);
+      frame->*descriptor.mid = followers_[i][1].update(value);
+      frame->*descriptor.fast = followers_[i][2].update(value);
+    }
+  }
+
+  void VisitBuffers(const BufferVisitor& visit) const final {
+    visit(this, sizeof(*this));
+    visit(previous_.data(), previous_.size() * sizeof(float));
+    visit(followers_.data(), followers_.size() * sizeof(followers_[0]));
+  }
+
+ private:
+  struct Descriptor {
+    float AudioFrame::*value;
+    float AudioFrame::*slow;
+    float AudioFrame::*mid;
+    float AudioFrame::*fast;
+  };
+  static constexpr Descriptor kDescriptors[] = {
+      {&AudioFrame::spectral_centroid, &AudioFrame::spectral_centroid_slow,
+       &AudioFrame::spectral_centroid_mid, &AudioFrame::spectral_centroid_fast},
+      {&AudioFrame::spectral_spread, &AudioFrame::spectral_spread_slow,
+       &AudioFrame::spectral_spread_mid, &AudioFrame::spectral_spread_fast},
+      {&AudioFrame::spectral_rolloff, &AudioFrame::spectral_rolloff_slow,
+       &AudioFrame::spectral_rolloff_mid, &AudioFrame::spectral_rolloff_fast},
+      {&AudioFrame::spectral_flatness, &AudioFrame::spectral_flatness_slow,
+       &AudioFrame::spectral_flatness_mid, &AudioFrame::spectral_flatness_fast},
+      {&AudioFrame::spectral_flux, &AudioFrame::spectral_flux_slow,
+       &AudioFrame::spectral_flux_mid, &AudioFrame::spectral_flux_fast},
+      {&AudioFrame::spectral_crest, &AudioFrame::spectral_crest_slow,
+       &AudioFrame::spectral_crest_mid, &AudioFrame::spectral_crest_fast},
+  };
+
+  // First bin at which the cumulative magnitude reaches `threshold`. Whole
+  // blocks are skipped by their sums, which do not depend on each other, so
+  // the running total costs one add per block.
+  static size_t GetRolloff(const float* magnitude, size_t bins,
+                           float threshold) {
+    float cumulative = 0;
+    size_t begin = 0;
+    for (; begin + kLanes <= bins; begin += kLanes) {
+      float block_sum = 0;
+      for (size_t lane = 0; lane < kLanes; ++lane) {
+        block_sum += magnitude[begin + lane];
+      }
+      if (cumulative + block_sum >= threshold) {
+        break;
+      }
+      cumulative += block_sum;
+    }
+    for (size_t i = begin; i < bins; ++i) {
+      cumulative += magnitude[i];
+      if (cumulative >= threshold) {
+        return i;
+      }
+    }
+    return bins - 1;
+  }
+
+  const float sample_rate_;
+  std::vector<float> previous_;
+  std::vector<std::array<ExpDecayFollower, 3>> followers_;
+};
+
+// YIN fundamental frequency estimation over a sliding history window. The
+// difference function is expanded into energies and a cross-correlation,
+// which is computed with FFTs, so each frame costs O(W log W) for a window of
+// W samples instead of O(W^2).
+class PitchProcessor final : public AudioProcessor {
+ public:
+  explicit PitchProcessor(const AudioProcessorOptions& options)
+      : sample_rate_(options.sample_rate),
+        max_lag_(std::ceil(options.sample_rate / options.pitch_min_frequency)),
+        min_lag_(options.sample_rate / options.pitch_max_frequency),
+        real_fft_(options.pitch_window),
+        history_(options.pitch_window, 0),
+        segment_(options.pitch_window, 0),
+        spectrum_(real_fft_.transform_size() + 2, 0),
+        segment_spectrum_(real_fft_.transform_size() + 2, 0),
+        correlation_(real_fft_.transform_size(), 0),
+        difference_(max_lag_ + 2, 0) {}
+
+  void Process(AudioFrame* frame) final {
+    static constexpr float kThreshold = .15;
+    const size_t window = history_.size();
+    const size_t size = std::min(frame->samples.size(), window);
+    std::copy(history_.begin() + size, history_.end(), history_.begin());
+    std::copy(frame->samples.end() - size, frame->samples.end(),
+              history_.end() - size);
+
+    // d(t) = sum_{j < n} (x[j] - x[j + t])^2 = e(0) + e(t) - 2 r(t), where
+    // e(t) is the energy of x[t, t + n) and r the cross-correlation of the
+    // first n samples with the whole window. The correlation cannot wrap
+    // around since n + max_lag_ + 1 <= window <= transform size.
+    const size_t n = window - max_lag_ - 1;
+    std::copy(history_.begin(), history_.begin() + n, segment_.begin());
+    real_fft_.ForwardTransform(history_, &spectrum_);
+    real_fft_.ForwardTransform(segment_, &segment_spectrum_);
+    for (size_t i = 0; i < spectrum_.size(); i += 2) {
+      const float a_real = segment_spectrum_[i];
+      const float a_img = segment_spectrum_[i + 1];
+      const float x_real = spectrum_[i];
+      const float x_img = spectrum_[i + 1];
+      segment_spectrum_[i] = a_real * x_real + a_img * x_img;
+      segment_spectrum_[i + 1] = a_real * x_img - a_img * x_real;
+    }
+    real_fft_.InverseTransform(segment_spectrum_, &correlation_);
+    const float scale = 1.f / real_fft_.transform_size();
+
+    // Cumulative mean normalised difference, d'(t) = d(t) t / sum d(1..t).
+    const float* const x = history_.data();
+    float energy = 0;
+    for (size_t j = 0; j < n; ++j) {
+      energy += x[j] * x[j];
+    }
+    const float energy0 = energy;
+    float sum = 0;
+    difference_[0] = 1;
+    for (size_t lag = 1; lag < difference_.size(); ++lag) {
+      energy += x[lag + n - 1] * x[lag + n - 1] - x[lag - 1] * x[lag - 1];
+      const float d = std::max(
+          energy0 + energy - 2 * scale * correlation_[lag], 0.f);
+      sum += d;
+      difference_[lag] = sum > 0 ? d * lag / sum : 1;
+    }
+
+    // The first dip below the threshold, followed down to its minimum. If
+    // there is none the signal is treated as unpitched.
+    size_t lag = min_lag_;
+    while (lag <= max_lag_ && difference_[lag] >= kThreshold) {
+      ++lag;
+    }
+    if (lag > max_lag_) {
+      const auto minimum =
+          std::min_element(difference_.begin() + min_lag_,
+                           difference_.begin() + max_lag_ + 1);
+      frame->pitch = 0;
+      frame->pitch_clarity = std::clamp(1 - *minimum, 0.f, 1.f);
+      return;
+    }
+    while (lag < max_lag_ && difference_[lag + 1] < difference_[lag]) {
+      ++lag;
+    }
+
+    // Parabolic interpolation through the minimum and its neighbours.
+    const float before = difference_[lag - 1];
+    const float at = difference_[lag];
+    const float after = difference_[lag + 1];
+    const float curvature = before - 2 * at + after;
+    float offset = 0;
+    if (curvature > 0) {
+      offset = std::clamp(.5f * (before - after) / curvature, -.5f, .5f);
+    }
+    frame->pitch = sample_rate_ / (lag + offset);
+    frame->pitch_clarity = std::clamp(
+        1 - (at - .25f * (before - after) * offset), 0.f, 1.f);
+  }
+
+  void Prepare() final { real_fft_.Prepare(); }
+
+  void VisitBuffers(const BufferVisitor& visit) const final {
+    visit(this, sizeof(*this));
+    real_fft_.VisitBuffers(visit);
+    for (const AlignedVector<float>* buffer :
+         {&history_, &segment_, &spectrum_, &segment_spectrum_,
+          &correlation_}) {
+      visit(buffer->data(), buffer->size() * sizeof(float));
+    }
+    visit(difference_.data(), difference_.size() * sizeof(float));
+  }
+
+ private:
+  const float sample_rate_;
+  // Lags searched, in samples. ParseAudioProcessorOptions() ensures that
+  // 2 <= min_lag_ < max_lag_ <= pitch_window / 2.
+  const size_t max_lag_;
+  const size_t min_lag_;
+  RealFFT real_fft_;
+  AlignedVector<float> history_;
+  // The first samples of `history_`, zero-padded to the window size.
+  AlignedVector<float> segment_;
+  AlignedVector<float> spectrum_;
+  AlignedVector<float> segment_spectrum_;
+  AlignedVector<float> correlation_;
+  std::vector<float> difference_;
+};
+
+// Reduces the waveform, the band signals and the spectrum to a fixed number of
+// display columns. Every input sample is read exactly once per frame.
+class EnvelopeProcessor final : public AudioProcessor {
+ public:
+  explicit EnvelopeProcessor(const AudioProcessorOptions& options)
+      : decibels_(NeedsDecibels(options)),
+        sample_edges_(GetEdges(options.buffer_size, options.display_width,
+                               /*log_scale=*/false)),
+        bin_edges_(
+            GetEdges(RealFFT::GetTransformSize(options.buffer_size) / 2 + 1,
+                     options.display_bins, options.display_log_frequency)) {}
+
+  void Process(AudioFrame* frame) final {
+    for (const auto& [samples, envelope] : {
+             std::make_pair(frame->samples.data(), &frame->envelope),
+             std::make_pair(frame->bass.samples.data(), &frame->bass.envelope),
+             std::make_pair(frame->mid.samples.data(), &frame->mid.envelope),
+             std::make_pair(frame->high.samples.data(),
+                            &frame->high.envelope),
+         }) {
+      for (size_t column = 0; column + 1 < sample_edges_.size(); ++column) {
+        const size_t begin = sample_edges_[column];
+        const size_t size = GetColumnSize(sample_edges_, column);
+        int32_t min[kLanes], max[kLanes];
+        float sums[kLanes] = {};
+        std::fill(std::begin(min), std::end(min), OrderedBits(samples[begin]));
+        std::fill(std::begin(max), std::end(max), OrderedBits(samples[begin]));
+        size_t i = 0;
+        for (; i + kLanes <= size; i += kLanes) {
+          for (size_t lane = 0; lane < kLanes; ++lane) {
+            const float sample = samples[begin + i + lane];
+            min[lane] = std::min(min[lane], OrderedBits(sample));
+            max[lane] = std::max(max[lane], OrderedBits(sample));
+            sums[lane] += sample * sample;
+          }
+        }
+        for (; i < size; ++i) {
+          const float sample = samples[begin + i];
+          min[0] = std::min(min[0], OrderedBits(sample));
+          max[0] = std::max(max[0], OrderedBits(sample));
+          sums[0] += sample * sample;
+        }
+        float sum = 0;
+        for (size_t lane = 1; lane < kLanes; ++lane) {
+          min[0] = std::min(min[0], min[lane]);
+          max[0] = std::max(max[0], max[lane]);
+          sum += sums[lane];
+        }
+        envelope->min[column] = FromOrderedBits(min[0]);
+        envelope->max[column] = FromOrderedBits(max[0]);
+        envelope->rms[column] = std::sqrt((sum + sums[0]) / size);
+      }
+    }
+
+    // Decibels can be negative, so the spectrum needs OrderedBits() rather
+    // than AbsBits().
+    const float* const spectrum =
+        decibels_ ? frame->db_fft.data() : frame->absolute_fft.data();
+    for (size_t column = 0; column + 1 < bin_edges_.size(); ++column) {
+      const size_t begin = bin_edges_[column];
+      const size_t size = GetColumnSize(bin_edges_, column);
+      int32_t max[kLanes];
+      std::fill(std::begin(max), std::end(max), OrderedBits(spectrum[begin]));
+      size_t i = 0;
+      for (; i + kLanes <= size; i += kLanes) {
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+          max[lane] =
+              std::max(max[lane], OrderedBits(spectrum[begin + i + lane]));
+        }
+      }
+      for (; i < size; ++i) {
+        max[0] = std::max(max[0], OrderedBits(spectrum[begin + i]));
+      }
+      frame->display_spectrum[column] =
+          FromOrderedBits(*std::max_element(std::begin(max), std::end(max)));
+    }
+  }
+
+  void VisitBuffers(const BufferVisitor& visit) const final {
+    visit(this, sizeof(*this));
+    visit(sample_edges_.data(), sample_edges_.size() * sizeof(size_t));
+    visit(bin_edges_.data(), bin_edges_.size() * sizeof(size_t));
+  }
+
+ private:
+  // Boundaries of `columns` consecutive ranges covering `size` values, either
+  // evenly or logarithmically spaced. When there are more columns than values
+  // some ranges are empty; see GetColumnSize().
+  static std::vector<size_t> GetEdges(size_t size, size_t columns,
+                                      bool log_scale) {
+    if (columns == 0) {
+      return {};
+    }
+    std::vector<size_t> edges(columns + 1);
+    for (size_t column = 0; column < columns; ++column) {
+      size_t begin = column * size / columns;
+      if (log_scale && column > 0) {
+        // Bin 0 (DC) goes into the first column, the rest spread
+        // logarithmically from bin 1 up to Nyquist.
+        begin = std::pow(float(size), float(column) / columns);
+      }
+      edges[column] = std::min(begin, size - 1);
+    }
+    edges[columns] = size;
+    return edges;
+  }
+
+  // Empty columns repeat the value at their start, which is always in range.
+  static size_t GetColumnSize(const std::vector<size_t>& edges,
+                              size_t column) {
+    return std::max<size_t>(edges[column + 1] - edges[column], 1);
+  }
+
+  const bool decibels_;
+  const std::vector<size_t> sample_edges_;
+  const std::vector<size_t> bin_edges_;
+};
+
 class NormalizeProcessor final : public AudioProcessor {
  public:
   explicit NormalizeProcessor() {}
@@ -252,6 +958,8 @@ class NormalizeProcessor final : public AudioProcessor {
     }
   };
 
+  void VisitBuffers(const BufferVisitor& visit) const final {}
+
  private:
   static float div(float num, float div) {
     if (num <= 0 || div <= 0) {
@@ -263,27 +971,92 @@ class NormalizeProcessor final : public AudioProcessor {
 
 }  // namespace
 
-AudioFrame::AudioFrame(size_t buffer_size)
-    : samples(buffer_size, 0),
-      fft(buffer_size + 2, 0),
-      absolute_fft(fft.size() / 2, 0),
-      bass(buffer_size),
-      mid(buffer_size),
-      high(buffer_size) {}
+size_t GetSampleSize(SampleFormat sample_format) {
+  switch (sample_format) {
+    case SampleFormat::kFloat32:
+      return sizeof(float);
+    case SampleFormat::kInt16:
+      return sizeof(int16_t);
+    case SampleFormat::kInt24:
+      return 3;
+  }
+  return 0;
+}
 
-AudioFrame::Band::Band(size_t buffer_size) : samples(buffer_size, 0) {}
+AudioFrame::AudioFrame(const AudioProcessorOptions& options)
+    : input(options.sample_format == SampleFormat::kFloat32
+                ? 0
+                : options.buffer_size * GetSampleSize(options.sample_format),
+            0),
+      samples(options.buffer_size, 0),
+      fft(RealFFT::GetTransformSize(options.buffer_size) + 2, 0),
+      absolute_fft(NeedsMagnitude(options) ? fft.size() / 2 : 0, 0),
+      power_fft(NeedsPower(options) ? fft.size() / 2 : 0, 0),
+      db_fft(NeedsDecibels(options) ? fft.size() / 2 : 0, 0),
+      envelope(options.display_width),
+      display_spectrum(options.display_bins, 0),
+      bass(options.buffer_size, options.display_width),
+      mid(options.buffer_size, options.display_width),
+      high(options.buffer_size, options.display_width) {}
+
+void AudioFrame::VisitBuffers(const BufferVisitor& visit) const {
+  visit(this, sizeof(*this));
+  visit(input.data(), input.size());
+  visit(samples.data(), samples.size() * sizeof(float));
+  visit(fft.data(), fft.size() * sizeof(float));
+  visit(absolute_fft.data(), absolute_fft.size() * sizeof(float));
+  visit(power_fft.data(), power_fft.size() * sizeof(float));
+  visit(db_fft.data(), db_fft.size() * sizeof(float));
+  visit(display_spectrum.data(), display_spectrum.size() * sizeof(float));
+  envelope.VisitBuffers(visit);
+  for (const Band* band : {&bass, &mid, &high}) {
+    visit(band->samples.data(), band->samples.size() * sizeof(float));
+    band->envelope.VisitBuffers(visit);
+  }
+}
+
+AudioFrame::Envelope::Envelope(size_t width)
+    : min(width, 0), max(width, 0), rms(width, 0) {}
+
+void AudioFrame::Envelope::VisitBuffers(const BufferVisitor& visit) const {
+  for (const std::vector<float>* values : {&min, &max, &rms}) {
+    visit(values->data(), values->size() * sizeof(float));
+  }
+}
+
+AudioFrame::Band::Band(size_t buffer_size, size_t display_width)
+    : samples(buffer_size, 0), envelope(display_width) {}
 
 std::unique_ptr<AudioProcessor> CreateAudioProcessor(
-    AudioProcessorOptions options) {
-  std::vector<std::unique_ptr<AudioProcessor>> processors;
-  processors.emplace_back(new FFTProcessor(options.buffer_size));
-  processors.emplace_back(
-      new BandProcessor(options.buffer_size, options.sample_rate));
-  processors.emplace_back(
-      new PeakProcessor(options.buffer_size, options.sample_rate));
-  processors.emplace_back(new NormalizeProcessor());
+    AudioProcessorOptions options, TriggerEventSink on_trigger_events) {
+  std::vector<CompositeProcessor::Stage> stages;
+  stages.emplace_back("input", new InputProcessor(options.sample_format));
+  stages.emplace_back(
+      "bands", new BandProcessor(options.buffer_size, options.sample_rate));
+  // Triggers only need the samples and bands, so their events go out before
+  // the transform runs.
+  if (!options.triggers.empty()) {
+    stages.emplace_back(
+        "triggers",
+        new TriggerProcessor(options, std::move(on_trigger_events)));
+  }
+  stages.emplace_back("fft", new FFTProcessor(options));
+  stages.emplace_back(
+      "followers", new PeakProcessor(options.buffer_size, options.sample_rate));
+  stages.emplace_back("normalize", new NormalizeProcessor());
+  if (options.spectral_descriptors) {
+    stages.emplace_back(
+        "spectral",
+        new SpectralProcessor(options.buffer_size, options.sample_rate));
+  }
+  if (options.pitch) {
+    stages.emplace_back("pitch", new PitchProcessor(options));
+  }
+  if (options.display_width > 0 || options.display_bins > 0) {
+    stages.emplace_back("envelope", new EnvelopeProcessor(options));
+  }
   return std::unique_ptr<AudioProcessor>(
-      new CompositeProcessor(std::move(processors)));
+      new CompositeProcessor(std::move(stages)));
 }
 
 }  // namespace rtaudio
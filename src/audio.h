@@ -1,17 +1,110 @@
 #ifndef AUDIO_H
 #define AUDIO_H
 
+#include <array>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 
+#include "fft.h"
+
 namespace rtaudio {
 
+// Sample format the device is captured in. Integer formats are converted to
+// float by the first processing stage instead of by PortAudio.
+enum class SampleFormat { kFloat32, kInt16, kInt24 };
+
+size_t GetSampleSize(SampleFormat sample_format);
+
+// Signal a trigger follows: the full-band samples or one of the bands.
+enum class TriggerSource { kFull, kBass, kMid, kHigh };
+
+// A per-sample envelope follower on the absolute value of `source` that turns
+// on when the envelope reaches `threshold` and off when it falls below
+// `threshold - hysteresis`. Attack and release are time constants in seconds.
+struct TriggerOptions {
+  std::string name;
+  TriggerSource source = TriggerSource::kFull;
+  float threshold = 0;
+  float hysteresis = 0;
+  float attack = .001;
+  float release = .1;
+};
+
+struct AudioProcessorOptions {
+  size_t buffer_size;
+  float sample_rate;
+  SampleFormat sample_format = SampleFormat::kFloat32;
+  bool spectral_descriptors = false;
+  // Spectra computed from `fft`. The magnitude is only computed when
+  // requested here or needed by the spectral descriptors.
+  bool magnitude_spectrum = true;
+  bool power_spectrum = false;
+  bool db_spectrum = false;
+  float db_floor = -100;
+  // Level-of-detail output for displays. `display_width` columns of min/max/
+  // RMS envelope for the waveform and each band, and `display_bins` max-pooled
+  // spectrum bins (in dB when `db_spectrum` is set, magnitude otherwise).
+  // Zero disables either.
+  size_t display_width = 0;
+  size_t display_bins = 0;
+  bool display_log_frequency = false;
+  // Whether `samples`, `fft`, the spectra above and the band samples are
+  // exported to JS. Clients that only draw the envelopes can turn this off,
+  // which also skips computing spectra nothing else needs.
+  bool full_resolution = true;
+  // Fundamental frequency tracking over the last `pitch_window` samples,
+  // searched between the min and max frequency in Hz.
+  bool pitch = false;
+  size_t pitch_window = 2048;
+  float pitch_min_frequency = 60;
+  float pitch_max_frequency = 1000;
+  std::vector<TriggerOptions> triggers;
+};
+
+// A trigger turning on or off. `sample` is on the same count as
+// AudioFrame::start_sample, and `level` is the envelope at the crossing.
+struct TriggerEvent {
+  uint32_t trigger;  // Index into AudioProcessorOptions::triggers.
+  bool on;
+  uint64_t sample;
+  float level;
+};
+
+// Receives every buffer touched while processing a frame, so that callers can
+// pre-fault and lock them before going real-time.
+using BufferVisitor = std::function<void(const void* data, size_t size)>;
+
 struct AudioFrame {
-  explicit AudioFrame(size_t buffer_size);
+  explicit AudioFrame(const AudioProcessorOptions& options);
 
-  std::vector<float> samples;
-  std::vector<float> fft;
+  void VisitBuffers(const BufferVisitor& visit) const;
+
+  // Per-column extent of a signal, one entry per display column.
+  struct Envelope {
+    explicit Envelope(size_t width);
+
+    void VisitBuffers(const BufferVisitor& visit) const;
+
+    std::vector<float> min;
+    std::vector<float> max;
+    std::vector<float> rms;
+  };
+
+  // Index of the first sample of this frame among those read since the
+  // stream was last started. Input lost to overflows is not counted. Set by
+  // the stream before processing.
+  uint64_t start_sample = 0;
+  // Raw device samples, only used for integer sample formats. Float32 input
+  // is read straight into `samples`.
+  std::vector<uint8_t> input;
+  AlignedVector<float> samples;
+  AlignedVector<float> fft;
   std::vector<float> absolute_fft;
+  std::vector<float> power_fft;
+  std::vector<float> db_fft;
   float rms = 0;
   float rms_slow_max = 0;
   float rms_slow = 0;
@@ -28,10 +121,53 @@ struct AudioFrame {
   float normalized_peak_mid = 0;
   float normalized_peak_fast = 0;
 
+  // Spectral descriptors, only computed with `spectral_descriptors`.
+  float spectral_centroid = 0;  // Hz.
+  float spectral_centroid_slow = 0;
+  float spectral_centroid_mid = 0;
+  float spectral_centroid_fast = 0;
+  float spectral_spread = 0;  // Hz.
+  float spectral_spread_slow = 0;
+  float spectral_spread_mid = 0;
+  float spectral_spread_fast = 0;
+  float spectral_rolloff = 0;  // Hz below which 85% of the magnitude lies.
+  float spectral_rolloff_slow = 0;
+  float spectral_rolloff_mid = 0;
+  float spectral_rolloff_fast = 0;
+  float spectral_flatness = 0;  // 0 (tonal) to 1 (noise-like).
+  float spectral_flatness_slow = 0;
+  float spectral_flatness_mid = 0;
+  float spectral_flatness_fast = 0;
+  float spectral_flux = 0;
+  float spectral_flux_slow = 0;
+  float spectral_flux_mid = 0;
+  float spectral_flux_fast = 0;
+  float spectral_crest = 0;
+  float spectral_crest_slow = 0;
+  float spectral_crest_mid = 0;
+  float spectral_crest_fast = 0;
+
+  // Zero when no periodicity was found. Clarity is in [0, 1], higher meaning
+  // a more clearly periodic signal.
+  float pitch = 0;
+  float pitch_clarity = 0;
+
+  Envelope envelope;
+  std::vector<float> display_spectrum;
+
+  // Crossings within this frame in sample order. Stored inline so that
+  // copying a frame never allocates; crossings beyond the capacity are only
+  // counted.
+  static constexpr size_t kMaxTriggerEvents = 64;
+  std::array<TriggerEvent, kMaxTriggerEvents> trigger_events;
+  size_t trigger_event_count = 0;
+  size_t dropped_trigger_events = 0;
+
   struct Band {
-    explicit Band(size_t buffer_size);
+    explicit Band(size_t buffer_size, size_t display_width);
 
     std::vector<float> samples;
+    Envelope envelope;
     float rms = 0;
     float rms_slow_max = 0;
     float rms_slow = 0;
@@ -58,15 +194,18 @@ class AudioProcessor {
  public:
   virtual ~AudioProcessor() = default;
   virtual void Process(AudioFrame* frame) = 0;
+  // Called on the processing thread before its first Process(), to allocate
+  // any per-thread state up front.
+  virtual void Prepare() {}
+  virtual void VisitBuffers(const BufferVisitor& visit) const = 0;
 };
 
-struct AudioProcessorOptions {
-  size_t buffer_size;
-  float sample_rate;
-};
+// Called with the frame as soon as its trigger events are known, before the
+// rest of the chain runs.
+using TriggerEventSink = std::function<void(const AudioFrame& frame)>;
 
 std::unique_ptr<AudioProcessor> CreateAudioProcessor(
-    AudioProcessorOptions options);
+    AudioProcessorOptions options, TriggerEventSink on_trigger_events = {});
 
 }  // namespace rtaudio
 
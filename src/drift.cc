@@ -0,0 +1,121 @@
+#include "drift.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace rtaudio {
+namespace {
+
+// Seconds of audio before the rate estimate is trusted.
+constexpr double kMinEstimateSeconds = 2;
+// Largest correction applied on top of the measured ratio.
+constexpr double kMaxCorrection = .005;
+// Correction per buffer of latency error.
+constexpr double kCorrectionGain = .00002;
+// Smoothing of the buffered latency, which jumps by a whole device block
+// whenever one arrives.
+constexpr double kFillSmoothing = .02;
+
+}  // namespace
+
+void ClockEstimator::Update(size_t count, double stream_time) {
+  samples_ += count;
+  if (first_time_ < 0) {
+    first_time_ = stream_time;
+    first_samples_ = samples_;
+    return;
+  }
+  const double elapsed = stream_time - first_time_;
+  if (elapsed >= kMinEstimateSeconds) {
+    rate_.store((samples_ - first_samples_) / elapsed,
+                std::memory_order_relaxed);
+  }
+}
+
+DriftCompensator::DriftCompensator(size_t buffer_size)
+    : target_fill_(2 * buffer_size),
+      ring_(8 * buffer_size, 0),
+      scratch_(2 * buffer_size + 2, 0) {}
+
+size_t DriftCompensator::Available() const {
+  return write_index_.load(std::memory_order_acquire) -
+         read_index_.load(std::memory_order_relaxed);
+}
+
+void DriftCompensator::Push(const float* samples, size_t count,
+                            double stream_time) {
+  clock_.Update(count, stream_time);
+  const size_t write = write_index_.load(std::memory_order_relaxed);
+  const size_t read = read_index_.load(std::memory_order_acquire);
+  const size_t space = ring_.size() - (write - read);
+  if (count > space) {
+    overflows_.fetch_add(1, std::memory_order_relaxed);
+    count = space;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    ring_[(write + i) % ring_.size()] = samples[i];
+  }
+  write_index_.store(write + count, std::memory_order_release);
+}
+
+void DriftCompensator::Copy(size_t offset, size_t count, float* output) const {
+  const size_t begin =
+      (read_index_.load(std::memory_order_relaxed) + offset) % ring_.size();
+  const size_t first = std::min(count, ring_.size() - begin);
+  std::copy_n(ring_.begin() + begin, first, output);
+  std::copy_n(ring_.begin(), count - first, output + first);
+}
+
+void DriftCompensator::Pull(float* output, size_t count,
+                            double reference_rate) {
+  const size_t available = Available();
+  if (!primed_) {
+    // Build up the target latency before starting, so that ordinary jitter
+    // in block arrival does not cause underruns.
+    if (available < target_fill_) {
+      std::fill_n(output, count, 0.f);
+      return;
+    }
+    primed_ = true;
+    average_fill_ = available;
+  }
+  average_fill_ += kFillSmoothing * (available - average_fill_);
+
+  double ratio = 1;
+  if (rate() > 0 && reference_rate > 0) {
+    ratio = rate() / reference_rate;
+  }
+  // Latency error, in output buffers.
+  const double error =
+      (average_fill_ - static_cast<double>(target_fill_)) / count;
+  ratio *= 1 + std::clamp(kCorrectionGain * error, -kMaxCorrection,
+                          kMaxCorrection);
+  ratio_.store(ratio, std::memory_order_relaxed);
+
+  // Input needed for `count` outputs, including the right-hand neighbour of
+  // the last interpolated sample.
+  const size_t needed =
+      static_cast<size_t>(phase_ + (count - 1) * ratio) + 2;
+  if (needed > available || needed > scratch_.size()) {
+    underruns_.fetch_add(1, std::memory_order_relaxed);
+    std::fill_n(output, count, 0.f);
+    primed_ = false;
+    phase_ = 0;
+    return;
+  }
+  float* const input = scratch_.data();
+  Copy(0, needed, input);
+  for (size_t i = 0; i < count; ++i) {
+    const double position = phase_ + i * ratio;
+    const size_t index = static_cast<size_t>(position);
+    const float fraction = static_cast<float>(position - index);
+    output[i] = input[index] + fraction * (input[index + 1] - input[index]);
+  }
+  const double end = phase_ + count * ratio;
+  const size_t consumed = static_cast<size_t>(end);
+  phase_ = end - consumed;
+  read_index_.store(read_index_.load(std::memory_order_relaxed) + consumed,
+                    std::memory_order_release);
+}
+
+}  // namespace rtaudio
@@ -0,0 +1,79 @@
+#ifndef DRIFT_H
+#define DRIFT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rtaudio {
+
+// Measures a device's effective sample rate from the number of samples it has
+// delivered against its stream time.
+class ClockEstimator {
+ public:
+  // Called from the device's reader thread after each read of `count` samples
+  // that completed at `stream_time` (Pa_GetStreamTime, in seconds).
+  void Update(size_t count, double stream_time);
+
+  // Measured rate in samples per second, or 0 until enough time has passed
+  // for a stable estimate. Safe to call from any thread.
+  double rate() const { return rate_.load(std::memory_order_relaxed); }
+
+ private:
+  uint64_t samples_ = 0;
+  uint64_t first_samples_ = 0;
+  double first_time_ = -1;
+  std::atomic<double> rate_{0};
+};
+
+// Carries one secondary device's samples across to the reference device's
+// timeline. The device's reader thread pushes blocks in; the reference thread
+// pulls blocks out, resampled with linear interpolation by the ratio between
+// the two measured clock rates, trimmed by a slow correction that holds the
+// buffered latency at its target.
+class DriftCompensator {
+ public:
+  explicit DriftCompensator(size_t buffer_size);
+
+  // Producer side. Samples that do not fit are dropped and counted as an
+  // overflow.
+  void Push(const float* samples, size_t count, double stream_time);
+
+  // Consumer side. Writes `count` samples on the reference timeline, or
+  // silence (counted as an underrun) if not enough input is buffered.
+  void Pull(float* output, size_t count, double reference_rate);
+
+  double rate() const { return clock_.rate(); }
+  // Input samples consumed per output sample in the last Pull().
+  double ratio() const { return ratio_.load(std::memory_order_relaxed); }
+  uint64_t underruns() const {
+    return underruns_.load(std::memory_order_relaxed);
+  }
+  uint64_t overflows() const {
+    return overflows_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  size_t Available() const;
+  void Copy(size_t offset, size_t count, float* output) const;
+
+  const size_t target_fill_;
+  std::vector<float> ring_;
+  std::atomic<size_t> write_index_{0};
+  std::atomic<size_t> read_index_{0};
+  ClockEstimator clock_;
+
+  // Consumer state.
+  std::vector<float> scratch_;
+  double phase_ = 0;
+  double average_fill_ = 0;
+  bool primed_ = false;
+  std::atomic<double> ratio_{1};
+  std::atomic<uint64_t> underruns_{0};
+  std::atomic<uint64_t> overflows_{0};
+};
+
+}  // namespace rtaudio
+
+#endif  // DRIFT_H
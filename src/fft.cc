@@ -2,47 +2,139 @@
 
 #include <math.h>
 
-#include <cstring>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 #include <iostream>
+#include <map>
+#include <mutex>
 
 namespace rtaudio {
+namespace {
+
+// Returns the process-wide plan for real transforms of `size`, creating it on
+// first use. Entries are weak so plans are freed with their last user.
+std::shared_ptr<PFFFT_Setup> GetSharedSetup(int size) {
+  static std::mutex mutex;
+  static std::map<int, std::weak_ptr<PFFFT_Setup>> setups;
+  std::lock_guard<std::mutex> lock(mutex);
+  std::weak_ptr<PFFFT_Setup>& entry = setups[size];
+  if (std::shared_ptr<PFFFT_Setup> setup = entry.lock()) {
+    return setup;
+  }
+  std::shared_ptr<PFFFT_Setup> setup(pffft_new_setup(size, PFFFT_REAL),
+                                     pffft_destroy_setup);
+  entry = setup;
+  return setup;
+}
+
+bool HasOnlyFactors235(int n) {
+  for (const int factor : {2, 3, 5}) {
+    while (n % factor == 0) {
+      n /= factor;
+    }
+  }
+  return n == 1;
+}
+
+}  // namespace
 
 RealFFT::RealFFT(int size)
     : size_(size),
-      pffft_setup_(pffft_new_setup(size, PFFFT_REAL)),
-      input_((float*)pffft_aligned_malloc(size * sizeof(float))),
-      work_((float*)pffft_aligned_malloc(size * sizeof(float))),
-      output_((float*)pffft_aligned_malloc(size * sizeof(float))) {}
+      transform_size_(GetTransformSize(size)),
+      pffft_setup_(GetSharedSetup(transform_size_)) {}
+
+RealFFT::Scratch& RealFFT::GetThreadScratch() {
+  thread_local Scratch scratch;
+  return scratch;
+}
 
-RealFFT::~RealFFT() {
-  pffft_aligned_free(output_);
-  pffft_aligned_free(work_);
-  pffft_aligned_free(input_);
-  pffft_destroy_setup(pffft_setup_);
+float* RealFFT::GetScratch(AlignedVector<float> Scratch::*buffer,
+                           size_t size) {
+  AlignedVector<float>& vector = GetThreadScratch().*buffer;
+  if (vector.size() < size) {
+    vector.resize(size);
+  }
+  return vector.data();
+}
+
+void RealFFT::Prepare() const {
+  GetScratch(&Scratch::work, transform_size_);
+  GetScratch(&Scratch::input, transform_size_);
+}
+
+int RealFFT::GetTransformSize(int size) {
+  static constexpr int kMultiple = 32;
+  int transform_size = std::max(size + kMultiple - 1, kMultiple) / kMultiple *
+                       kMultiple;
+  while (!HasOnlyFactors235(transform_size)) {
+    transform_size += kMultiple;
+  }
+  return transform_size;
 }
 
 void RealFFT::ForwardTransform(const float* input, float* output) {
-  std::memcpy(input_, input, size_ * sizeof(float));
-  pffft_transform_ordered(pffft_setup_, input_, output_, work_, PFFFT_FORWARD);
-  std::memcpy(output, output_, size_ * sizeof(float));
-  output[1] = output[size_ + 1] = 0;
-  output[size_] = abs(output_[1]);
+  if (transform_size_ != size_) {
+    float* padded = GetScratch(&Scratch::input, transform_size_);
+    std::copy(input, input + size_, padded);
+    std::fill(padded + size_, padded + transform_size_, 0.f);
+    input = padded;
+  }
+  float* work = GetScratch(&Scratch::work, transform_size_);
+  pffft_transform_ordered(pffft_setup_.get(), input, output, work,
+                          PFFFT_FORWARD);
+  // pffft packs the (real) Nyquist bin into the imaginary part of the DC bin.
+  const float nyquist = output[1];
+  output[1] = output[transform_size_ + 1] = 0;
+  output[transform_size_] = nyquist;
+}
+
+void RealFFT::InverseTransform(const float* input, float* output) {
+  float* packed = GetScratch(&Scratch::input, transform_size_);
+  std::copy(input, input + transform_size_, packed);
+  packed[1] = input[transform_size_];
+  float* work = GetScratch(&Scratch::work, transform_size_);
+  pffft_transform_ordered(pffft_setup_.get(), packed, output, work,
+                          PFFFT_BACKWARD);
 }
 
-void RealFFT::ForwardTransform(const std::vector<float>& input,
-                               std::vector<float>* output) {
+void RealFFT::ForwardTransform(const AlignedVector<float>& input,
+                               AlignedVector<float>* output) {
   if (input.size() != size_) {
     std::cerr << "input->size() != size_" << std::endl;
     return;
   }
-  if (output->size() != size_ + 2) {
-    std::cerr << "output->size() != size_ + 2" << std::endl;
+  if (output->size() != transform_size_ + 2) {
+    std::cerr << "output->size() != transform_size_ + 2" << std::endl;
+    return;
+  }
+  if (!pffft_setup_) {
+    std::cerr << "pffft_new_setup(" << transform_size_ << ") failed"
+              << std::endl;
     return;
   }
   ForwardTransform(input.data(), output->data());
 }
 
-void RealFFT::GetAbsolute(const std::vector<float>& input,
+void RealFFT::InverseTransform(const AlignedVector<float>& input,
+                               AlignedVector<float>* output) {
+  if (input.size() != transform_size_ + 2) {
+    std::cerr << "input.size() != transform_size_ + 2" << std::endl;
+    return;
+  }
+  if (output->size() != transform_size_) {
+    std::cerr << "output->size() != transform_size_" << std::endl;
+    return;
+  }
+  if (!pffft_setup_) {
+    std::cerr << "pffft_new_setup(" << transform_size_ << ") failed"
+              << std::endl;
+    return;
+  }
+  InverseTransform(input.data(), output->data());
+}
+
+void RealFFT::GetAbsolute(const AlignedVector<float>& input,
                           std::vector<float>* output) {
   if (output->size() != input.size() / 2) {
     std::cerr << "output->size() != input.size() / 2" << std::endl;
@@ -53,11 +145,56 @@ void RealFFT::GetAbsolute(const std::vector<float>& input,
 
 void RealFFT::GetAbsolute(const float* input, size_t input_size,
                           float* output) {
-  for (size_t i = 0; i < input_size / 2 + 1; ++i) {
+  for (size_t i = 0; i < input_size / 2; ++i) {
     float real = input[2 * i];
     float img = input[2 * i + 1];
     output[i] = sqrt(real * real + img * img);
   }
 }
 
+void RealFFT::GetPower(const AlignedVector<float>& input,
+                       std::vector<float>* power, std::vector<float>* decibels,
+                       float floor_db) {
+  for (const std::vector<float>* output : {power, decibels}) {
+    if (output && output->size() != input.size() / 2) {
+      std::cerr << "output->size() != input.size() / 2" << std::endl;
+      return;
+    }
+  }
+  float* const power_data = power ? power->data() : nullptr;
+  float* const decibels_data = decibels ? decibels->data() : nullptr;
+  if (power && decibels) {
+    GetPower<true, true>(input.data(), input.size(), power_data, decibels_data,
+                         floor_db);
+  } else if (power) {
+    GetPower<true, false>(input.data(), input.size(), power_data, nullptr,
+                          floor_db);
+  } else if (decibels) {
+    GetPower<false, true>(input.data(), input.size(), nullptr, decibels_data,
+                          floor_db);
+  }
+}
+
+template <bool kPower, bool kDecibels>
+void RealFFT::GetPower(const float* input, size_t input_size, float* power,
+                       float* decibels, float floor_db) {
+  static constexpr float kDecibelsPerOctave = 3.01029996f;  // 10 * log10(2).
+  // Clamping the power first keeps FastLog2 away from zero and denormals.
+  const float floor_power =
+      std::max(std::pow(10.f, floor_db / 10), FLT_MIN);
+  for (size_t i = 0; i < input_size / 2; ++i) {
+    const float real = input[2 * i];
+    const float img = input[2 * i + 1];
+    const float bin_power = real * real + img * img;
+    if (kPower) {
+      power[i] = bin_power;
+    }
+    if (kDecibels) {
+      decibels[i] = std::max(
+          kDecibelsPerOctave * FastLog2(std::max(bin_power, floor_power)),
+          floor_db);
+    }
+  }
+}
+
 }  // namespace rtaudio
@@ -1,30 +1,137 @@
 #ifndef FFT_H
 #define FFT_H
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
 #include <vector>
 
 #include "pffft.h"
 
 namespace rtaudio {
 
+// Allocator backed by pffft_aligned_malloc, so buffers can be handed to pffft
+// directly instead of being copied into separately allocated aligned storage.
+template <typename T>
+struct AlignedAllocator {
+  using value_type = T;
+
+  AlignedAllocator() = default;
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U>&) {}
+
+  T* allocate(size_t n) {
+    void* data = pffft_aligned_malloc(n * sizeof(T));
+    if (!data) {
+      throw std::bad_alloc();
+    }
+    return static_cast<T*>(data);
+  }
+  void deallocate(T* data, size_t) { pffft_aligned_free(data); }
+
+  template <typename U>
+  bool operator==(const AlignedAllocator<U>&) const {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const AlignedAllocator<U>&) const {
+    return false;
+  }
+};
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+// Approximates log2(x) for positive, normal `x` with an absolute error below
+// 1.1e-4 (under 0.0004 dB). The exponent is read from the bit pattern and
+// log2 of the mantissa comes from a degree-4 minimax polynomial, so the
+// function is branch-free and loops over it vectorise.
+inline float FastLog2(float x) {
+  uint32_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  const float exponent = static_cast<int32_t>(bits >> 23) - 127;
+  bits = (bits & 0x007fffff) | 0x3f800000;  // Mantissa in [1, 2).
+  float mantissa;
+  std::memcpy(&mantissa, &bits, sizeof(mantissa));
+  const float m = mantissa - 1;
+  return exponent +
+         m * (1.43901467f +
+              m * (-0.67994404f + m * (0.32559565f + m * -0.08476861f)));
+}
+
 class RealFFT {
  public:
+  // Any size is accepted. Sizes pffft cannot transform directly are
+  // zero-padded up to GetTransformSize(size).
   RealFFT(int size);
-  ~RealFFT();
-  void ForwardTransform(const std::vector<float>& input,
-                        std::vector<float>* output);
-  static void GetAbsolute(const std::vector<float>& input,
+
+  // Smallest size >= `size` that pffft supports for real transforms: a
+  // multiple of 32 with no prime factors other than 2, 3 and 5.
+  static int GetTransformSize(int size);
+  int transform_size() const { return transform_size_; }
+
+  // `input` holds `size` samples and `output` receives transform_size() + 2
+  // values. Both buffers are pffft-aligned, so unpadded transforms read and
+  // write them in place without staging copies.
+  void ForwardTransform(const AlignedVector<float>& input,
+                        AlignedVector<float>* output);
+  // Inverse of ForwardTransform(): `input` holds transform_size() + 2 values
+  // in the same layout and `output` receives transform_size() samples. As
+  // with pffft, the result is scaled by transform_size().
+  void InverseTransform(const AlignedVector<float>& input,
+                        AlignedVector<float>* output);
+  static void GetAbsolute(const AlignedVector<float>& input,
                           std::vector<float>* output);
+  // Computes the power |X|^2 and/or its level in dB (10 * log10 |X|^2, no
+  // normalisation, clamped below at `floor_db`) of every bin in a single
+  // pass. Either output may be null.
+  static void GetPower(const AlignedVector<float>& input,
+                       std::vector<float>* power, std::vector<float>* decibels,
+                       float floor_db);
+
+  // Sizes the calling thread's scratch for this transform, so that later
+  // transforms on that thread do not allocate.
+  void Prepare() const;
+
+  // Calls `visit(data, size)` for every buffer the transform uses on the
+  // calling thread: the object and that thread's scratch, which Prepare()
+  // should have sized already. pffft does not expose the size of the shared
+  // plan, so it is not included.
+  template <typename Visit>
+  void VisitBuffers(const Visit& visit) const {
+    visit(this, sizeof(*this));
+    const Scratch& scratch = GetThreadScratch();
+    for (const AlignedVector<float>* buffer : {&scratch.work, &scratch.input}) {
+      visit(buffer->data(), buffer->size() * sizeof(float));
+    }
+  }
 
  private:
+  // Per-thread work and padding space, grown on demand. Each thread
+  // transforms with its own buffers, so concurrent transforms on a shared
+  // plan need no locking.
+  struct Scratch {
+    AlignedVector<float> work;
+    AlignedVector<float> input;
+  };
+
+  static Scratch& GetThreadScratch();
+  static float* GetScratch(AlignedVector<float> Scratch::*buffer, size_t size);
+
   void ForwardTransform(const float* input, float* output);
+  void InverseTransform(const float* input, float* output);
   static void GetAbsolute(const float* input, size_t input_size, float* output);
+  template <bool kPower, bool kDecibels>
+  static void GetPower(const float* input, size_t input_size, float* power,
+                       float* decibels, float floor_db);
 
   int size_;
-  PFFFT_Setup* pffft_setup_;
-  float* input_;
-  float* work_;
-  float* output_;
+  int transform_size_;
+  // Plans are read-only once created and are shared by every RealFFT of the
+  // same transform size in the process.
+  std::shared_ptr<PFFFT_Setup> pffft_setup_;
 };
 
 }  // namespace rtaudio
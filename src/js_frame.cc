@@ -0,0 +1,191 @@
+#include "js_frame.h"
+
+#include <cstring>
+#include <tuple>
+#include <utility>
+
+namespace rtaudio {
+namespace {
+
+// Scalar spectral descriptors exported when `spectralDescriptors` is set.
+constexpr std::pair<const char*, float AudioFrame::*> kSpectralFields[] = {
+    {"spectralCentroid", &AudioFrame::spectral_centroid},
+    {"spectralCentroidSlow", &AudioFrame::spectral_centroid_slow},
+    {"spectralCentroidMid", &AudioFrame::spectral_centroid_mid},
+    {"spectralCentroidFast", &AudioFrame::spectral_centroid_fast},
+    {"spectralSpread", &AudioFrame::spectral_spread},
+    {"spectralSpreadSlow", &AudioFrame::spectral_spread_slow},
+    {"spectralSpreadMid", &AudioFrame::spectral_spread_mid},
+    {"spectralSpreadFast", &AudioFrame::spectral_spread_fast},
+    {"spectralRolloff", &AudioFrame::spectral_rolloff},
+    {"spectralRolloffSlow", &AudioFrame::spectral_rolloff_slow},
+    {"spectralRolloffMid", &AudioFrame::spectral_rolloff_mid},
+    {"spectralRolloffFast", &AudioFrame::spectral_rolloff_fast},
+    {"spectralFlatness", &AudioFrame::spectral_flatness},
+    {"spectralFlatnessSlow", &AudioFrame::spectral_flatness_slow},
+    {"spectralFlatnessMid", &AudioFrame::spectral_flatness_mid},
+    {"spectralFlatnessFast", &AudioFrame::spectral_flatness_fast},
+    {"spectralFlux", &AudioFrame::spectral_flux},
+    {"spectralFluxSlow", &AudioFrame::spectral_flux_slow},
+    {"spectralFluxMid", &AudioFrame::spectral_flux_mid},
+    {"spectralFluxFast", &AudioFrame::spectral_flux_fast},
+    {"spectralCrest", &AudioFrame::spectral_crest},
+    {"spectralCrestSlow", &AudioFrame::spectral_crest_slow},
+    {"spectralCrestMid", &AudioFrame::spectral_crest_mid},
+    {"spectralCrestFast", &AudioFrame::spectral_crest_fast},
+};
+
+template <typename Values>
+void CopyToJs(const Values& values, Napi::Value js_values) {
+  memcpy(js_values.As<Napi::Float32Array>().Data(), values.data(),
+         sizeof(float) * values.size());
+}
+
+// `{min, max, rms}`, one entry per display column.
+Napi::Object NewJsEnvelope(Napi::Env env,
+                           const AudioFrame::Envelope& envelope) {
+  Napi::Object js_envelope = Napi::Object::New(env);
+  js_envelope["min"] = Napi::Float32Array::New(env, envelope.min.size());
+  js_envelope["max"] = Napi::Float32Array::New(env, envelope.max.size());
+  js_envelope["rms"] = Napi::Float32Array::New(env, envelope.rms.size());
+  return js_envelope;
+}
+
+void UpdateJsEnvelope(const AudioFrame::Envelope& envelope,
+                      Napi::Value js_envelope) {
+  const Napi::Object object = js_envelope.As<Napi::Object>();
+  CopyToJs(envelope.min, object.Get("min"));
+  CopyToJs(envelope.max, object.Get("max"));
+  CopyToJs(envelope.rms, object.Get("rms"));
+}
+
+}  // namespace
+
+Napi::Object NewJsFrame(Napi::Env env, const AudioProcessorOptions& options,
+                        const AudioFrame& frame) {
+  Napi::Object js_frame = Napi::Object::New(env);
+  js_frame["sampleRate"] = Napi::Number::New(env, options.sample_rate);
+  if (options.full_resolution) {
+    js_frame["samples"] = Napi::Float32Array::New(env, frame.samples.size());
+    js_frame["fft"] = Napi::Float32Array::New(env, frame.fft.size());
+    if (options.magnitude_spectrum) {
+      js_frame["absoluteFft"] =
+          Napi::Float32Array::New(env, frame.absolute_fft.size());
+    }
+    if (options.power_spectrum) {
+      js_frame["powerFft"] =
+          Napi::Float32Array::New(env, frame.power_fft.size());
+    }
+    if (options.db_spectrum) {
+      js_frame["dbFft"] = Napi::Float32Array::New(env, frame.db_fft.size());
+    }
+  }
+  if (options.display_width > 0) {
+    js_frame["envelope"] = NewJsEnvelope(env, frame.envelope);
+  }
+  if (options.display_bins > 0) {
+    js_frame["displaySpectrum"] =
+        Napi::Float32Array::New(env, frame.display_spectrum.size());
+  }
+  for (const auto band_name : {"bass", "mid", "high"}) {
+    Napi::Object band = Napi::Object::New(env);
+    if (options.full_resolution) {
+      band["samples"] = Napi::Float32Array::New(env, frame.samples.size());
+    }
+    if (options.display_width > 0) {
+      band["envelope"] = NewJsEnvelope(env, frame.envelope);
+    }
+    js_frame[band_name] = band;
+  }
+  return js_frame;
+}
+
+void UpdateJsFrame(Napi::Env env, const AudioProcessorOptions& options,
+                   const AudioFrame& frame, Napi::Object js_frame) {
+  if (options.full_resolution) {
+    CopyToJs(frame.samples, js_frame.Get("samples"));
+    CopyToJs(frame.fft, js_frame.Get("fft"));
+    for (const auto& [name, enabled, spectrum] : {
+             std::make_tuple("absoluteFft", options.magnitude_spectrum,
+                             &frame.absolute_fft),
+             std::make_tuple("powerFft", options.power_spectrum,
+                             &frame.power_fft),
+             std::make_tuple("dbFft", options.db_spectrum, &frame.db_fft),
+         }) {
+      if (enabled) {
+        Napi::Float32Array js_spectrum =
+            js_frame.Get(name).As<Napi::Float32Array>();
+        memcpy(js_spectrum.Data(), spectrum->data(),
+               sizeof(float) * spectrum->size());
+      }
+    }
+  }
+  if (options.display_width > 0) {
+    UpdateJsEnvelope(frame.envelope, js_frame.Get("envelope"));
+  }
+  if (options.display_bins > 0) {
+    CopyToJs(frame.display_spectrum, js_frame.Get("displaySpectrum"));
+  }
+  js_frame["startSample"] =
+      Napi::Number::New(env, static_cast<double>(frame.start_sample));
+  js_frame["rms"] = Napi::Number::New(env, frame.rms);
+  js_frame["rmsSlow"] = Napi::Number::New(env, frame.rms_slow);
+  js_frame["rmsMid"] = Napi::Number::New(env, frame.rms_mid);
+  js_frame["rmsFast"] = Napi::Number::New(env, frame.rms_fast);
+  js_frame["normalizedRms"] = Napi::Number::New(env, frame.normalized_rms);
+  js_frame["normalizedRmsMid"] =
+      Napi::Number::New(env, frame.normalized_rms_mid);
+  js_frame["normalizedRmsFast"] =
+      Napi::Number::New(env, frame.normalized_rms_fast);
+  js_frame["peak"] = Napi::Number::New(env, frame.peak);
+  js_frame["peakSlow"] = Napi::Number::New(env, frame.peak_slow);
+  js_frame["peakMid"] = Napi::Number::New(env, frame.peak_mid);
+  js_frame["peakFast"] = Napi::Number::New(env, frame.peak_fast);
+  js_frame["normalizedPeak"] = Napi::Number::New(env, frame.normalized_peak);
+  js_frame["normalizedPeakMid"] =
+      Napi::Number::New(env, frame.normalized_peak_mid);
+  js_frame["normalizedPeakFast"] =
+      Napi::Number::New(env, frame.normalized_peak_fast);
+  if (options.pitch) {
+    js_frame["pitch"] = Napi::Number::New(env, frame.pitch);
+    js_frame["pitchClarity"] = Napi::Number::New(env, frame.pitch_clarity);
+  }
+  if (options.spectral_descriptors) {
+    for (const auto& [name, field] : kSpectralFields) {
+      js_frame[name] = Napi::Number::New(env, frame.*field);
+    }
+  }
+  for (auto& [band_name, band] : {
+           std::make_pair("bass", &frame.bass),
+           std::make_pair("mid", &frame.mid),
+           std::make_pair("high", &frame.high),
+       }) {
+    Napi::Object js_band = js_frame.Get(band_name).As<Napi::Object>();
+    if (options.full_resolution) {
+      CopyToJs(band->samples, js_band.Get("samples"));
+    }
+    if (options.display_width > 0) {
+      UpdateJsEnvelope(band->envelope, js_band.Get("envelope"));
+    }
+    js_band["rms"] = Napi::Number::New(env, band->rms);
+    js_band["rmsSlow"] = Napi::Number::New(env, band->rms_slow);
+    js_band["rmsMid"] = Napi::Number::New(env, band->rms_mid);
+    js_band["rmsFast"] = Napi::Number::New(env, band->rms_fast);
+    js_band["normalizedRms"] = Napi::Number::New(env, band->normalized_rms);
+    js_band["normalizedRmsMid"] =
+        Napi::Number::New(env, band->normalized_rms_mid);
+    js_band["normalizedRmsFast"] =
+        Napi::Number::New(env, band->normalized_rms_fast);
+    js_band["peak"] = Napi::Number::New(env, band->peak);
+    js_band["peakSlow"] = Napi::Number::New(env, band->peak_slow);
+    js_band["peakMid"] = Napi::Number::New(env, band->peak_mid);
+    js_band["peakFast"] = Napi::Number::New(env, band->peak_fast);
+    js_band["normalizedPeak"] = Napi::Number::New(env, band->normalized_peak);
+    js_band["normalizedPeakMid"] =
+        Napi::Number::New(env, band->normalized_peak_mid);
+    js_band["normalizedPeakFast"] =
+        Napi::Number::New(env, band->normalized_peak_fast);
+  }
+}
+
+}  // namespace rtaudio
@@ -0,0 +1,21 @@
+#ifndef JS_FRAME_H
+#define JS_FRAME_H
+
+#include <napi.h>
+
+#include "audio.h"
+
+namespace rtaudio {
+
+// Creates the JS object that frames produced with `options` are copied into,
+// with its typed arrays sized for `frame`.
+Napi::Object NewJsFrame(Napi::Env env, const AudioProcessorOptions& options,
+                        const AudioFrame& frame);
+
+// Copies `frame` into `js_frame`, which must come from NewJsFrame.
+void UpdateJsFrame(Napi::Env env, const AudioProcessorOptions& options,
+                   const AudioFrame& frame, Napi::Object js_frame);
+
+}  // namespace rtaudio
+
+#endif  // JS_FRAME_H
@@ -0,0 +1,57 @@
+#include "js_profiler.h"
+
+#include "profiler.h"
+
+namespace rtaudio {
+namespace {
+
+void Enable(const Napi::CallbackInfo& info) {
+  Profiler::Shared().SetEnabled(true);
+}
+
+void Disable(const Napi::CallbackInfo& info) {
+  Profiler::Shared().SetEnabled(false);
+}
+
+Napi::Value IsEnabled(const Napi::CallbackInfo& info) {
+  return Napi::Boolean::New(info.Env(), Profiler::Shared().enabled());
+}
+
+void Reset(const Napi::CallbackInfo& info) { Profiler::Shared().Reset(); }
+
+// Per-stage durations in microseconds, keyed by stage name.
+Napi::Value GetStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Object stats = Napi::Object::New(env);
+  for (const TraceStats& stage : Profiler::Shared().GetStats()) {
+    Napi::Object js_stage = Napi::Object::New(env);
+    js_stage["count"] =
+        Napi::Number::New(env, static_cast<double>(stage.count));
+    js_stage["mean"] = Napi::Number::New(env, stage.mean_us);
+    js_stage["p50"] = Napi::Number::New(env, stage.p50_us);
+    js_stage["p90"] = Napi::Number::New(env, stage.p90_us);
+    js_stage["p99"] = Napi::Number::New(env, stage.p99_us);
+    js_stage["max"] = Napi::Number::New(env, stage.max_us);
+    stats[stage.name] = js_stage;
+  }
+  return stats;
+}
+
+Napi::Value GetChromeTrace(const Napi::CallbackInfo& info) {
+  return Napi::String::New(info.Env(), Profiler::Shared().GetChromeTrace());
+}
+
+}  // namespace
+
+Napi::Object NewJsProfiler(Napi::Env env) {
+  Napi::Object profiler = Napi::Object::New(env);
+  profiler["enable"] = Napi::Function::New(env, Enable);
+  profiler["disable"] = Napi::Function::New(env, Disable);
+  profiler["isEnabled"] = Napi::Function::New(env, IsEnabled);
+  profiler["reset"] = Napi::Function::New(env, Reset);
+  profiler["getStats"] = Napi::Function::New(env, GetStats);
+  profiler["getChromeTrace"] = Napi::Function::New(env, GetChromeTrace);
+  return profiler;
+}
+
+}  // namespace rtaudio
@@ -0,0 +1,14 @@
+#ifndef JS_PROFILER_H
+#define JS_PROFILER_H
+
+#include <napi.h>
+
+namespace rtaudio {
+
+// `{enable, disable, isEnabled, reset, getStats, getChromeTrace}` functions
+// controlling the process-wide Profiler.
+Napi::Object NewJsProfiler(Napi::Env env);
+
+}  // namespace rtaudio
+
+#endif  // JS_PROFILER_H
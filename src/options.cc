@@ -0,0 +1,291 @@
+#include "options.h"
+
+#include <cmath>
+#include <string>
+#include <utility>
+
+namespace rtaudio {
+
+std::optional<SampleFormat> ParseSampleFormat(const std::string& name) {
+  if (name == "float32") {
+    return SampleFormat::kFloat32;
+  }
+  if (name == "int16") {
+    return SampleFormat::kInt16;
+  }
+  if (name == "int24") {
+    return SampleFormat::kInt24;
+  }
+  return std::nullopt;
+}
+
+const char* GetSampleFormatName(SampleFormat sample_format) {
+  switch (sample_format) {
+    case SampleFormat::kFloat32:
+      return "float32";
+    case SampleFormat::kInt16:
+      return "int16";
+    case SampleFormat::kInt24:
+      return "int24";
+  }
+  return "float32";
+}
+
+std::optional<TriggerSource> ParseTriggerSource(const std::string& name) {
+  if (name == "full") {
+    return TriggerSource::kFull;
+  }
+  if (name == "bass") {
+    return TriggerSource::kBass;
+  }
+  if (name == "mid") {
+    return TriggerSource::kMid;
+  }
+  if (name == "high") {
+    return TriggerSource::kHigh;
+  }
+  return std::nullopt;
+}
+
+namespace {
+
+bool ParseTriggerOptions(Napi::Env env, const Napi::Value& value,
+                         TriggerOptions* trigger) {
+  if (!value.IsObject()) {
+    NAPI_THROW(
+        Napi::Error::New(env, std::string("Invalid value for trigger: ") +
+                                  value.ToString().Utf8Value()),
+        false);
+  }
+  const Napi::Object options = value.As<Napi::Object>();
+  if (const Napi::Value name = options["name"]; !name.IsUndefined()) {
+    if (!name.IsString()) {
+      NAPI_THROW(Napi::Error::New(
+                     env, std::string("Invalid value for trigger name: ") +
+                              name.ToString().Utf8Value()),
+                 false);
+    }
+    trigger->name = name.ToString().Utf8Value();
+  }
+  if (const Napi::Value source = options["source"]; !source.IsUndefined()) {
+    std::optional<TriggerSource> parsed;
+    if (source.IsString()) {
+      parsed = ParseTriggerSource(source.ToString().Utf8Value());
+    }
+    if (!parsed) {
+      NAPI_THROW(Napi::Error::New(
+                     env, std::string("Invalid value for trigger source: ") +
+                              source.ToString().Utf8Value()),
+                 false);
+    }
+    trigger->source = *parsed;
+  }
+  const Napi::Value threshold = options["threshold"];
+  if (!threshold.IsNumber() || threshold.ToNumber().FloatValue() <= 0) {
+    NAPI_THROW(Napi::Error::New(
+                   env, std::string("Invalid value for trigger threshold: ") +
+                            threshold.ToString().Utf8Value()),
+               false);
+  }
+  trigger->threshold = threshold.ToNumber().FloatValue();
+  for (const auto& [name, field] : {
+           std::make_pair("hysteresis", &TriggerOptions::hysteresis),
+           std::make_pair("attack", &TriggerOptions::attack),
+           std::make_pair("release", &TriggerOptions::release),
+       }) {
+    if (const Napi::Value value = options[name]; !value.IsUndefined()) {
+      if (!value.IsNumber() || value.ToNumber().FloatValue() < 0) {
+        NAPI_THROW(Napi::Error::New(
+                       env, std::string("Invalid value for trigger ") + name +
+                                ": " + value.ToString().Utf8Value()),
+                   false);
+      }
+      trigger->*field = value.ToNumber().FloatValue();
+    }
+  }
+  if (trigger->hysteresis >= trigger->threshold) {
+    NAPI_THROW(Napi::Error::New(
+                   env, "trigger hysteresis must be below its threshold"),
+               false);
+  }
+  return true;
+}
+
+}  // namespace
+
+bool ParseAudioProcessorOptions(Napi::Env env, const Napi::Object& options,
+                                AudioProcessorOptions* processor_options) {
+  if (const Napi::Value value = options["sampleRate"]; !value.IsUndefined()) {
+    if (!value.IsNumber()) {
+      NAPI_THROW(
+          Napi::Error::New(env, std::string("Invalid value for sampleRate: ") +
+                                    value.ToString().Utf8Value()),
+          false);
+    }
+    processor_options->sample_rate = value.ToNumber().FloatValue();
+  } else {
+    processor_options->sample_rate = 48000;
+  }
+  if (const Napi::Value value = options["bufferSize"]; !value.IsUndefined()) {
+    if (!value.IsNumber()) {
+      NAPI_THROW(
+          Napi::Error::New(env, std::string("Invalid value for bufferSize: ") +
+                                    value.ToString().Utf8Value()),
+          false);
+    }
+    processor_options->buffer_size = value.ToNumber().Uint32Value();
+    if (processor_options->buffer_size == 0) {
+      NAPI_THROW(Napi::Error::New(env, "bufferSize must be positive"), false);
+    }
+  } else {
+    processor_options->buffer_size = 512;
+  }
+  if (const Napi::Value value = options["sampleFormat"];
+      !value.IsUndefined()) {
+    std::optional<SampleFormat> sample_format;
+    if (value.IsString()) {
+      sample_format = ParseSampleFormat(value.ToString().Utf8Value());
+    }
+    if (!sample_format) {
+      NAPI_THROW(Napi::Error::New(
+                     env, std::string("Invalid value for sampleFormat: ") +
+                              value.ToString().Utf8Value()),
+                 false);
+    }
+    processor_options->sample_format = *sample_format;
+  }
+  for (const auto& [name, field] : {
+           std::make_pair("spectralDescriptors",
+                          &AudioProcessorOptions::spectral_descriptors),
+           std::make_pair("magnitudeSpectrum",
+                          &AudioProcessorOptions::magnitude_spectrum),
+           std::make_pair("powerSpectrum",
+                          &AudioProcessorOptions::power_spectrum),
+           std::make_pair("dbSpectrum",
+                          &AudioProcessorOptions::db_spectrum),
+           std::make_pair("fullResolution",
+                          &AudioProcessorOptions::full_resolution),
+           std::make_pair("pitch", &AudioProcessorOptions::pitch),
+       }) {
+    if (const Napi::Value value = options[name]; !value.IsUndefined()) {
+      if (!value.IsBoolean()) {
+        NAPI_THROW(Napi::Error::New(env, std::string("Invalid value for ") +
+                                             name + ": " +
+                                             value.ToString().Utf8Value()),
+                   false);
+      }
+      processor_options->*field = value.ToBoolean().Value();
+    }
+  }
+  if (const Napi::Value value = options["dbFloor"]; !value.IsUndefined()) {
+    if (!value.IsNumber()) {
+      NAPI_THROW(
+          Napi::Error::New(env, std::string("Invalid value for dbFloor: ") +
+                                    value.ToString().Utf8Value()),
+          false);
+    }
+    processor_options->db_floor = value.ToNumber().FloatValue();
+  }
+  for (const auto& [name, field] : {
+           std::make_pair("displayWidth",
+                          &AudioProcessorOptions::display_width),
+           std::make_pair("displayBins", &AudioProcessorOptions::display_bins),
+       }) {
+    if (const Napi::Value value = options[name]; !value.IsUndefined()) {
+      if (!value.IsNumber() || value.ToNumber().DoubleValue() < 0) {
+        NAPI_THROW(Napi::Error::New(env, std::string("Invalid value for ") +
+                                             name + ": " +
+                                             value.ToString().Utf8Value()),
+                   false);
+      }
+      processor_options->*field = value.ToNumber().Uint32Value();
+    }
+  }
+  if (const Napi::Value value = options["pitchWindow"]; !value.IsUndefined()) {
+    if (!value.IsNumber()) {
+      NAPI_THROW(
+          Napi::Error::New(env, std::string("Invalid value for pitchWindow: ") +
+                                    value.ToString().Utf8Value()),
+          false);
+    }
+    processor_options->pitch_window = value.ToNumber().Uint32Value();
+    if (processor_options->pitch_window < 64) {
+      NAPI_THROW(Napi::Error::New(env, "pitchWindow must be at least 64"),
+                 false);
+    }
+  }
+  for (const auto& [name, field] : {
+           std::make_pair("pitchMinFrequency",
+                          &AudioProcessorOptions::pitch_min_frequency),
+           std::make_pair("pitchMaxFrequency",
+                          &AudioProcessorOptions::pitch_max_frequency),
+       }) {
+    if (const Napi::Value value = options[name]; !value.IsUndefined()) {
+      if (!value.IsNumber() || value.ToNumber().FloatValue() <= 0) {
+        NAPI_THROW(Napi::Error::New(env, std::string("Invalid value for ") +
+                                             name + ": " +
+                                             value.ToString().Utf8Value()),
+                   false);
+      }
+      processor_options->*field = value.ToNumber().FloatValue();
+    }
+  }
+  if (processor_options->pitch_min_frequency >=
+      processor_options->pitch_max_frequency) {
+    NAPI_THROW(Napi::Error::New(
+                   env, "pitchMinFrequency must be below pitchMaxFrequency"),
+               false);
+  }
+  if (processor_options->pitch) {
+    // YIN compares each lag over at least as many samples as the lag itself,
+    // and needs lags of at least 2 around the minimum it picks.
+    const float sample_rate = processor_options->sample_rate;
+    const size_t max_lag =
+        std::ceil(sample_rate / processor_options->pitch_min_frequency);
+    if (processor_options->pitch_window < 2 * max_lag) {
+      NAPI_THROW(Napi::Error::New(
+                     env, "pitchWindow must be at least " +
+                              std::to_string(2 * max_lag) +
+                              " to track pitchMinFrequency at this sampleRate"),
+                 false);
+    }
+    if (processor_options->pitch_max_frequency > sample_rate / 2) {
+      NAPI_THROW(
+          Napi::Error::New(
+              env, "pitchMaxFrequency must be at most half the sampleRate"),
+          false);
+    }
+  }
+  if (const Napi::Value value = options["triggers"]; !value.IsUndefined()) {
+    if (!value.IsArray()) {
+      NAPI_THROW(
+          Napi::Error::New(env, std::string("Invalid value for triggers: ") +
+                                    value.ToString().Utf8Value()),
+          false);
+    }
+    const Napi::Array triggers = value.As<Napi::Array>();
+    for (uint32_t i = 0; i < triggers.Length(); ++i) {
+      TriggerOptions trigger;
+      trigger.name = std::to_string(i);
+      if (!ParseTriggerOptions(env, triggers.Get(i), &trigger)) {
+        return false;
+      }
+      processor_options->triggers.push_back(std::move(trigger));
+    }
+  }
+  if (const Napi::Value value = options["displayScale"];
+      !value.IsUndefined()) {
+    const std::string scale =
+        value.IsString() ? value.ToString().Utf8Value() : "";
+    if (scale != "linear" && scale != "log") {
+      NAPI_THROW(Napi::Error::New(
+                     env, std::string("Invalid value for displayScale: ") +
+                              value.ToString().Utf8Value()),
+                 false);
+    }
+    processor_options->display_log_frequency = scale == "log";
+  }
+  return true;
+}
+
+}  // namespace rtaudio
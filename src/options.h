@@ -0,0 +1,25 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <napi.h>
+
+#include <optional>
+#include <string>
+
+#include "audio.h"
+
+namespace rtaudio {
+
+std::optional<SampleFormat> ParseSampleFormat(const std::string& name);
+const char* GetSampleFormatName(SampleFormat sample_format);
+std::optional<TriggerSource> ParseTriggerSource(const std::string& name);
+
+// Reads the processing options shared by every stream type (sampleRate,
+// bufferSize, sampleFormat and the spectrum and descriptor switches). Returns
+// false, with a pending JS exception, if any of them is invalid.
+bool ParseAudioProcessorOptions(Napi::Env env, const Napi::Object& options,
+                                AudioProcessorOptions* processor_options);
+
+}  // namespace rtaudio
+
+#endif  // OPTIONS_H
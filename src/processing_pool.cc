@@ -0,0 +1,147 @@
+#include "processing_pool.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "profiler.h"
+
+namespace rtaudio {
+
+struct ProcessingPool::Job {
+  const std::function<void(size_t)>* task;
+  size_t count;
+  std::atomic<size_t> next{0};
+  std::atomic<size_t> remaining;
+  std::mutex mutex;
+  std::condition_variable done;
+};
+
+struct ProcessingPool::Broadcast {
+  const std::function<void()>* task;
+  size_t remaining;  // Guarded by `mutex`.
+  std::mutex mutex;
+  std::condition_variable done;
+};
+
+ProcessingPool& ProcessingPool::Shared() {
+  static constexpr size_t kMaxQueueSize = 64;
+  static ProcessingPool pool(
+      std::max(std::thread::hardware_concurrency(), 2u) - 1, kMaxQueueSize);
+  return pool;
+}
+
+ProcessingPool::ProcessingPool(size_t thread_count, size_t max_queue_size)
+    : max_queue_size_(max_queue_size) {
+  for (size_t i = 0; i < thread_count; ++i) {
+    threads_.emplace_back([this] { WorkerLoop(); });
+  }
+}
+
+ProcessingPool::~ProcessingPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+void ProcessingPool::Run(size_t count,
+                         const std::function<void(size_t)>& task) {
+  if (count == 0) {
+    return;
+  }
+  auto job = std::make_shared<Job>();
+  job->task = &task;
+  job->count = count;
+  job->remaining = count;
+  size_t helpers = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const size_t wanted = std::min(count - 1, threads_.size());
+    while (helpers < wanted && queue_.size() < max_queue_size_) {
+      queue_.push_back(job);
+      ++helpers;
+    }
+  }
+  for (size_t i = 0; i < helpers; ++i) {
+    wake_.notify_one();
+  }
+  Work(job.get());
+  std::unique_lock<std::mutex> lock(job->mutex);
+  job->done.wait(lock, [&job] { return job->remaining.load() == 0; });
+}
+
+void ProcessingPool::RunOnEveryThread(const std::function<void()>& task) {
+  std::lock_guard<std::mutex> serial(broadcast_mutex_);
+  auto broadcast = std::make_shared<Broadcast>();
+  broadcast->task = &task;
+  broadcast->remaining = threads_.size();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    broadcast_ = broadcast;
+    ++broadcast_generation_;
+  }
+  wake_.notify_all();
+  task();
+  {
+    std::unique_lock<std::mutex> lock(broadcast->mutex);
+    broadcast->done.wait(lock,
+                         [&broadcast] { return broadcast->remaining == 0; });
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  broadcast_ = nullptr;
+}
+
+void ProcessingPool::WorkerLoop() {
+  Profiler::SetThreadName("ProcessingPool worker");
+  uint64_t broadcast_generation = 0;
+  while (true) {
+    std::shared_ptr<Job> job;
+    std::shared_ptr<Broadcast> broadcast;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [this, &broadcast_generation] {
+        return stopping_ || !queue_.empty() ||
+               broadcast_generation != broadcast_generation_;
+      });
+      if (stopping_) {
+        return;
+      }
+      if (broadcast_generation != broadcast_generation_) {
+        broadcast_generation = broadcast_generation_;
+        broadcast = broadcast_;
+      } else {
+        job = std::move(queue_.front());
+        queue_.pop_front();
+      }
+    }
+    if (broadcast) {
+      (*broadcast->task)();
+      std::lock_guard<std::mutex> lock(broadcast->mutex);
+      if (--broadcast->remaining == 0) {
+        broadcast->done.notify_all();
+      }
+      continue;
+    }
+    Work(job.get());
+  }
+}
+
+void ProcessingPool::Work(Job* job) {
+  while (true) {
+    const size_t index = job->next.fetch_add(1);
+    if (index >= job->count) {
+      return;
+    }
+    (*job->task)(index);
+    if (job->remaining.fetch_sub(1) == 1) {
+      std::lock_guard<std::mutex> lock(job->mutex);
+      job->done.notify_all();
+    }
+  }
+}
+
+}  // namespace rtaudio
@@ -0,0 +1,65 @@
+#ifndef PROCESSING_POOL_H
+#define PROCESSING_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rtaudio {
+
+// Fixed set of worker threads with a bounded queue, shared by every stream
+// that processes more than one channel. Idle workers sleep, so CPU use follows
+// the amount of work rather than the number of streams or channels.
+class ProcessingPool {
+ public:
+  // Process-wide pool with one worker per core, minus one for the caller.
+  static ProcessingPool& Shared();
+
+  ProcessingPool(size_t thread_count, size_t max_queue_size);
+  ProcessingPool(const ProcessingPool&) = delete;
+  ProcessingPool& operator=(const ProcessingPool&) = delete;
+  ~ProcessingPool();
+
+  // Calls `task(i)` for every i in [0, count) and returns once all calls have
+  // finished. The calling thread takes part in the work, and when the queue
+  // is full it simply does more of it itself, so this never blocks on the
+  // queue.
+  void Run(size_t count, const std::function<void(size_t)>& task);
+
+  // Calls `task()` once on every worker and once on the calling thread, and
+  // returns once all calls have finished. Used for per-thread setup, such as
+  // sizing thread_local scratch before real-time processing starts.
+  void RunOnEveryThread(const std::function<void()>& task);
+
+  size_t thread_count() const { return threads_.size(); }
+
+ private:
+  struct Job;
+  struct Broadcast;
+
+  void WorkerLoop();
+  static void Work(Job* job);
+
+  const size_t max_queue_size_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::deque<std::shared_ptr<Job>> queue_;
+  bool stopping_ = false;
+  // The current RunOnEveryThread() task. Workers run it once each time the
+  // generation changes.
+  std::shared_ptr<Broadcast> broadcast_;
+  uint64_t broadcast_generation_ = 0;
+  // Allows one RunOnEveryThread() call at a time.
+  std::mutex broadcast_mutex_;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace rtaudio
+
+#endif  // PROCESSING_POOL_H
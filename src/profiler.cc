@@ -0,0 +1,170 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+namespace rtaudio {
+
+// Owns the calling thread's ring, and marks it exited when the thread ends so
+// that it can be dropped once enough newer rings exist.
+struct Profiler::ThreadState {
+  ~ThreadState() {
+    if (ring) {
+      ring->exited.store(true, std::memory_order_relaxed);
+    }
+  }
+
+  const char* name = nullptr;
+  std::shared_ptr<Ring> ring;
+};
+
+Profiler::ThreadState& Profiler::GetThreadState() {
+  thread_local ThreadState state;
+  return state;
+}
+
+Profiler& Profiler::Shared() {
+  static Profiler profiler;
+  return profiler;
+}
+
+void Profiler::SetThreadName(const char* name) {
+  ThreadState& state = GetThreadState();
+  state.name = name;
+  if (state.ring) {
+    Profiler& profiler = Shared();
+    std::lock_guard<std::mutex> lock(profiler.mutex_);
+    state.ring->thread_name = name;
+  }
+}
+
+int64_t Profiler::Now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+Profiler::Ring* Profiler::GetThreadRing() {
+  ThreadState& state = GetThreadState();
+  if (!state.ring) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = rings_.begin();
+         rings_.size() >= kMaxRings && it != rings_.end();) {
+      it = (*it)->exited.load(std::memory_order_relaxed) ? rings_.erase(it)
+                                                         : it + 1;
+    }
+    state.ring = std::make_shared<Ring>(next_thread_id_++);
+    if (state.name) {
+      state.ring->thread_name = state.name;
+    }
+    rings_.push_back(state.ring);
+  }
+  return state.ring.get();
+}
+
+void Profiler::Record(const char* name, int64_t begin_ns, int64_t end_ns) {
+  Ring* const ring = GetThreadRing();
+  const uint64_t index = ring->finished.load(std::memory_order_relaxed);
+  ring->started.store(index + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  Ring::Slot& slot = ring->slots[index % kRingSize];
+  slot.name.store(name, std::memory_order_relaxed);
+  slot.begin_ns.store(begin_ns, std::memory_order_relaxed);
+  slot.duration_ns.store(end_ns - begin_ns, std::memory_order_relaxed);
+  ring->finished.store(index + 1, std::memory_order_release);
+}
+
+std::vector<TraceEvent> Profiler::GetEvents() {
+  std::vector<std::shared_ptr<Ring>> rings;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    rings = rings_;
+  }
+  const int64_t reset_ns = reset_ns_.load(std::memory_order_relaxed);
+  std::vector<TraceEvent> events;
+  for (const std::shared_ptr<Ring>& ring : rings) {
+    const uint64_t finished = ring->finished.load(std::memory_order_acquire);
+    const uint64_t first = finished > kRingSize ? finished - kRingSize : 0;
+    std::vector<TraceEvent> copied;
+    copied.reserve(finished - first);
+    for (uint64_t i = first; i < finished; ++i) {
+      const Ring::Slot& slot = ring->slots[i % kRingSize];
+      copied.push_back({slot.name.load(std::memory_order_relaxed),
+                        ring->thread_id,
+                        slot.begin_ns.load(std::memory_order_relaxed),
+                        slot.duration_ns.load(std::memory_order_relaxed)});
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t started = ring->started.load(std::memory_order_relaxed);
+    // Slot i may have been overwritten by write i + kRingSize.
+    const uint64_t valid = started > kRingSize ? started - kRingSize : 0;
+    for (uint64_t i = std::max(first, valid); i < finished; ++i) {
+      const TraceEvent& event = copied[i - first];
+      if (event.begin_ns >= reset_ns) {
+        events.push_back(event);
+      }
+    }
+  }
+  return events;
+}
+
+std::vector<TraceStats> Profiler::GetStats() {
+  std::map<std::string, std::vector<int64_t>> durations;
+  for (const TraceEvent& event : GetEvents()) {
+    durations[event.name].push_back(event.duration_ns);
+  }
+  std::vector<TraceStats> stats;
+  for (auto& [name, values] : durations) {
+    std::sort(values.begin(), values.end());
+    const auto percentile = [&values = values](double fraction) {
+      const size_t rank = fraction * (values.size() - 1) + .5;
+      return values[rank] / 1e3;
+    };
+    double total = 0;
+    for (const int64_t value : values) {
+      total += value;
+    }
+    stats.push_back({name, values.size(), total / values.size() / 1e3,
+                     percentile(.5), percentile(.9), percentile(.99),
+                     values.back() / 1e3});
+  }
+  return stats;
+}
+
+std::string Profiler::GetChromeTrace() {
+  const std::vector<TraceEvent> events = GetEvents();
+  std::ostringstream trace;
+  trace << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+  const char* separator = "";
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const std::shared_ptr<Ring>& ring : rings_) {
+      if (ring->thread_name.empty()) {
+        continue;
+      }
+      trace << separator
+            << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+            << ring->thread_id << ",\"args\":{\"name\":\""
+            << ring->thread_name << "\"}}";
+      separator = ",";
+    }
+  }
+  for (const TraceEvent& event : events) {
+    trace << separator << "{\"name\":\"" << event.name
+          << "\",\"cat\":\"rtaudio\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+          << event.thread_id << ",\"ts\":" << event.begin_ns / 1e3
+          << ",\"dur\":" << event.duration_ns / 1e3 << "}";
+    separator = ",";
+  }
+  trace << "],\"displayTimeUnit\":\"ms\"}";
+  return trace.str();
+}
+
+void Profiler::Reset() {
+  reset_ns_.store(Now(), std::memory_order_relaxed);
+}
+
+}  // namespace rtaudio
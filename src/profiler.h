@@ -0,0 +1,125 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace rtaudio {
+
+// One timed scope. `name` points at a string literal.
+struct TraceEvent {
+  const char* name;
+  int thread_id;
+  int64_t begin_ns;
+  int64_t duration_ns;
+};
+
+// Aggregate timings of every recorded event with the same name.
+struct TraceStats {
+  std::string name;
+  size_t count;
+  double mean_us;
+  double p50_us;
+  double p90_us;
+  double p99_us;
+  double max_us;
+};
+
+// Process-wide collector of ScopedTrace timings. Each thread records into its
+// own fixed-size ring without locks or allocation (after its first event), so
+// tracing can run on the reader threads. Older events are overwritten once a
+// ring is full.
+class Profiler {
+ public:
+  static Profiler& Shared();
+
+  Profiler() = default;
+  Profiler(const Profiler&) = delete;
+  Profiler& operator=(const Profiler&) = delete;
+
+  // Disabled by default. While disabled a ScopedTrace costs one relaxed load.
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+  void SetEnabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  // Names the calling thread in exported traces. `name` must outlive the
+  // thread; nothing is allocated until the thread records an event.
+  static void SetThreadName(const char* name);
+
+  void Record(const char* name, int64_t begin_ns, int64_t end_ns);
+
+  // Events recorded since the last Reset(), oldest first per thread. Safe to
+  // call while other threads are recording.
+  std::vector<TraceEvent> GetEvents();
+  std::vector<TraceStats> GetStats();
+  // Chrome trace event format, loadable in chrome://tracing and Perfetto.
+  std::string GetChromeTrace();
+  void Reset();
+
+  // Monotonic clock shared by every event, in nanoseconds.
+  static int64_t Now();
+
+ private:
+  static constexpr size_t kRingSize = 4096;
+  // Rings of exited threads are kept for export until this many exist.
+  static constexpr size_t kMaxRings = 32;
+
+  struct Ring {
+    struct Slot {
+      std::atomic<const char*> name{nullptr};
+      std::atomic<int64_t> begin_ns{0};
+      std::atomic<int64_t> duration_ns{0};
+    };
+
+    explicit Ring(int thread_id) : thread_id(thread_id) {}
+
+    const int thread_id;
+    std::string thread_name;  // Guarded by Profiler::mutex_.
+    std::atomic<bool> exited{false};
+    // Writes started and finished. A reader discards slots that a started
+    // write may have overwritten while it was copying them.
+    std::atomic<uint64_t> started{0};
+    std::atomic<uint64_t> finished{0};
+    std::array<Slot, kRingSize> slots;
+  };
+  struct ThreadState;
+
+  static ThreadState& GetThreadState();
+  Ring* GetThreadRing();
+
+  std::atomic<bool> enabled_{false};
+  std::atomic<int64_t> reset_ns_{0};
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<Ring>> rings_;
+  int next_thread_id_ = 1;
+};
+
+// Times the enclosing scope under `name`, which must be a string literal.
+class ScopedTrace {
+ public:
+  explicit ScopedTrace(const char* name)
+      : name_(Profiler::Shared().enabled() ? name : nullptr),
+        begin_ns_(name_ ? Profiler::Now() : 0) {}
+  ScopedTrace(const ScopedTrace&) = delete;
+  ScopedTrace& operator=(const ScopedTrace&) = delete;
+  ~ScopedTrace() {
+    if (name_) {
+      Profiler::Shared().Record(name_, begin_ns_, Profiler::Now());
+    }
+  }
+
+ private:
+  const char* const name_;
+  const int64_t begin_ns_;
+};
+
+}  // namespace rtaudio
+
+#endif  // PROFILER_H
@@ -0,0 +1,260 @@
+#include "realtime.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace rtaudio {
+namespace {
+
+#ifndef _WIN32
+int ToNativePolicy(SchedulingPolicy policy) {
+  switch (policy) {
+    case SchedulingPolicy::kFifo:
+      return SCHED_FIFO;
+    case SchedulingPolicy::kRoundRobin:
+      return SCHED_RR;
+    case SchedulingPolicy::kDefault:
+      break;
+  }
+  return SCHED_OTHER;
+}
+#endif
+
+size_t PageSize() {
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwPageSize;
+#else
+  static const size_t page_size = sysconf(_SC_PAGESIZE);
+  return page_size;
+#endif
+}
+
+// Rounds [data, data + size) out to whole pages.
+std::pair<const void*, size_t> PageAlign(const void* data, size_t size,
+                                         size_t page_size) {
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(data);
+  const uintptr_t aligned_begin = begin - begin % page_size;
+  const uintptr_t end = begin + size;
+  const uintptr_t aligned_end = (end + page_size - 1) / page_size * page_size;
+  return {reinterpret_cast<const void*>(aligned_begin),
+          aligned_end - aligned_begin};
+}
+
+// Lock counts of every page locked through a MemoryLock, keyed by page
+// address. Locks apply to whole pages and are not reference counted by the
+// OS, so buffers of two streams sharing a heap page would otherwise be
+// unlocked together when either stream stops.
+struct PageCounts {
+  std::mutex mutex;
+  std::map<uintptr_t, size_t> counts;
+};
+
+// Never destroyed, so streams torn down during exit can still unlock.
+PageCounts& GetPageCounts() {
+  static PageCounts* const page_counts = new PageCounts;
+  return *page_counts;
+}
+
+void UnlockPages(uintptr_t begin, uintptr_t end) {
+  if (begin == end) {
+    return;
+  }
+#ifdef _WIN32
+  VirtualUnlock(reinterpret_cast<void*>(begin), end - begin);
+#else
+  munlock(reinterpret_cast<void*>(begin), end - begin);
+#endif
+}
+
+}  // namespace
+
+std::optional<SchedulingPolicy> ParseSchedulingPolicy(
+    const std::string& name) {
+  if (name == "default") {
+    return SchedulingPolicy::kDefault;
+  }
+  if (name == "fifo") {
+    return SchedulingPolicy::kFifo;
+  }
+  if (name == "rr") {
+    return SchedulingPolicy::kRoundRobin;
+  }
+  return std::nullopt;
+}
+
+const char* GetSchedulingPolicyName(SchedulingPolicy policy) {
+  switch (policy) {
+    case SchedulingPolicy::kDefault:
+      return "default";
+    case SchedulingPolicy::kFifo:
+      return "fifo";
+    case SchedulingPolicy::kRoundRobin:
+      return "rr";
+  }
+  return "default";
+}
+
+SchedulingResult SetThreadScheduling(std::thread& thread,
+                                     SchedulingPolicy policy, int priority) {
+  SchedulingResult result;
+  if (policy == SchedulingPolicy::kDefault) {
+    return result;
+  }
+#ifdef _WIN32
+  result.error = "Real-time scheduling policies are not supported on Windows";
+  return result;
+#else
+  const int native_policy = ToNativePolicy(policy);
+  const int min_priority = sched_get_priority_min(native_policy);
+  const int max_priority = sched_get_priority_max(native_policy);
+  if (priority < min_priority) {
+    priority = min_priority;
+  } else if (priority > max_priority) {
+    priority = max_priority;
+  }
+  sched_param param{};
+  param.sched_priority = priority;
+  int error = pthread_setschedparam(thread.native_handle(), native_policy,
+                                    &param);
+#ifdef RLIMIT_RTPRIO
+  if (error == EPERM) {
+    // Unprivileged processes may still use priorities up to RLIMIT_RTPRIO.
+    rlimit limit{};
+    if (getrlimit(RLIMIT_RTPRIO, &limit) == 0 && limit.rlim_cur > 0 &&
+        static_cast<rlim_t>(priority) > limit.rlim_cur) {
+      param.sched_priority = static_cast<int>(limit.rlim_cur);
+      if (pthread_setschedparam(thread.native_handle(), native_policy,
+                                &param) == 0) {
+        result.policy = policy;
+        result.priority = param.sched_priority;
+        result.error = "Priority " + std::to_string(priority) +
+                       " not permitted, clamped to RLIMIT_RTPRIO";
+        return result;
+      }
+    }
+  }
+#endif
+  if (error != 0) {
+    result.error = std::string("pthread_setschedparam: ") + strerror(error);
+    return result;
+  }
+  result.policy = policy;
+  result.priority = priority;
+  return result;
+#endif
+}
+
+std::optional<std::string> SetThreadAffinity(std::thread& thread,
+                                             const std::vector<int>& cpus) {
+  if (cpus.empty()) {
+    return std::nullopt;
+  }
+#if defined(_WIN32)
+  DWORD_PTR mask = 0;
+  for (const int cpu : cpus) {
+    if (cpu < 0 || cpu >= static_cast<int>(sizeof(mask) * 8)) {
+      return "Invalid CPU index: " + std::to_string(cpu);
+    }
+    mask |= DWORD_PTR(1) << cpu;
+  }
+  if (!SetThreadAffinityMask(thread.native_handle(), mask)) {
+    return "SetThreadAffinityMask failed: " +
+           std::to_string(GetLastError());
+  }
+  return std::nullopt;
+#elif defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (const int cpu : cpus) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+      return "Invalid CPU index: " + std::to_string(cpu);
+    }
+    CPU_SET(cpu, &set);
+  }
+  if (int error =
+          pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set)) {
+    return std::string("pthread_setaffinity_np: ") + strerror(error);
+  }
+  return std::nullopt;
+#else
+  return std::string("CPU affinity is not supported on this platform");
+#endif
+}
+
+MemoryLock::~MemoryLock() { Unlock(); }
+
+std::optional<std::string> MemoryLock::Lock(const void* data, size_t size) {
+  if (!data || size == 0) {
+    return std::nullopt;
+  }
+  const size_t page_size = PageSize();
+  // Fault every page in up front so the first real-time pass does not.
+  const volatile char* bytes = static_cast<const volatile char*>(data);
+  for (size_t offset = 0; offset < size; offset += page_size) {
+    (void)bytes[offset];
+  }
+  (void)bytes[size - 1];
+
+  const auto range = PageAlign(data, size, page_size);
+  // Held across the lock call as well, so that a concurrent Unlock() cannot
+  // unlock these pages between it and the count update.
+  PageCounts& page_counts = GetPageCounts();
+  std::lock_guard<std::mutex> lock(page_counts.mutex);
+#ifdef _WIN32
+  if (!VirtualLock(const_cast<void*>(range.first), range.second)) {
+    return "VirtualLock failed: " + std::to_string(GetLastError());
+  }
+#else
+  if (mlock(range.first, range.second) != 0) {
+    return std::string("mlock: ") + strerror(errno);
+  }
+#endif
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(range.first);
+  for (uintptr_t page = begin; page < begin + range.second;
+       page += page_size) {
+    ++page_counts.counts[page];
+  }
+  ranges_.push_back(range);
+  locked_bytes_ += range.second;
+  return std::nullopt;
+}
+
+void MemoryLock::Unlock() {
+  const size_t page_size = PageSize();
+  PageCounts& page_counts = GetPageCounts();
+  std::lock_guard<std::mutex> lock(page_counts.mutex);
+  for (const auto& [data, size] : ranges_) {
+    // Only pages no other lock still holds are unlocked, in runs.
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(data);
+    uintptr_t run_begin = begin;
+    for (uintptr_t page = begin; page < begin + size; page += page_size) {
+      const auto count = page_counts.counts.find(page);
+      if (--count->second == 0) {
+        page_counts.counts.erase(count);
+      } else {
+        UnlockPages(run_begin, page);
+        run_begin = page + page_size;
+      }
+    }
+    UnlockPages(run_begin, begin + size);
+  }
+  ranges_.clear();
+  locked_bytes_ = 0;
+}
+
+}  // namespace rtaudio
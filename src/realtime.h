@@ -0,0 +1,62 @@
+#ifndef REALTIME_H
+#define REALTIME_H
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace rtaudio {
+
+enum class SchedulingPolicy { kDefault, kFifo, kRoundRobin };
+
+std::optional<SchedulingPolicy> ParseSchedulingPolicy(const std::string& name);
+const char* GetSchedulingPolicyName(SchedulingPolicy policy);
+
+struct SchedulingResult {
+  // Policy and priority actually in effect after the request.
+  SchedulingPolicy policy = SchedulingPolicy::kDefault;
+  int priority = 0;
+  // Set when the requested policy or priority could not be granted as is.
+  std::optional<std::string> error;
+};
+
+// Requests `policy` at `priority` for `thread`. The priority is clamped to the
+// range the policy supports; if the OS refuses it (typically EPERM without
+// CAP_SYS_NICE), the highest priority allowed by RLIMIT_RTPRIO is tried
+// before falling back to the default policy. Never throws.
+SchedulingResult SetThreadScheduling(std::thread& thread,
+                                     SchedulingPolicy policy, int priority);
+
+// Pins `thread` to the given CPU indices. Returns an error message on failure
+// or when the platform has no affinity support.
+std::optional<std::string> SetThreadAffinity(std::thread& thread,
+                                             const std::vector<int>& cpus);
+
+// Pre-faults and locks a set of memory ranges into RAM, and unlocks them again
+// on Unlock() or destruction. Ranges are locked as whole pages; pages shared
+// with another MemoryLock stay locked until every lock holding them unlocks.
+class MemoryLock {
+ public:
+  MemoryLock() = default;
+  MemoryLock(const MemoryLock&) = delete;
+  MemoryLock& operator=(const MemoryLock&) = delete;
+  ~MemoryLock();
+
+  // Touches every page of [data, data + size) and locks it. Returns an error
+  // message if the range could not be locked; the pages are still pre-faulted.
+  std::optional<std::string> Lock(const void* data, size_t size);
+  void Unlock();
+
+  size_t locked_bytes() const { return locked_bytes_; }
+
+ private:
+  std::vector<std::pair<const void*, size_t>> ranges_;
+  size_t locked_bytes_ = 0;
+};
+
+}  // namespace rtaudio
+
+#endif  // REALTIME_H
@@ -1,6 +1,8 @@
 #include <napi.h>
 
+#include "aggregate_stream.h"
 #include "device_info.h"
+#include "js_profiler.h"
 #include "stream.h"
 
 namespace rtaudio {
@@ -10,6 +12,9 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
               Napi::Function::New(env, GetDevices));
   exports.Set(Napi::String::New(env, "InputStream"),
               InputStream::GetClass(env));
+  exports.Set(Napi::String::New(env, "AggregateInputStream"),
+              AggregateInputStream::GetClass(env));
+  exports.Set(Napi::String::New(env, "profiler"), NewJsProfiler(env));
   return exports;
 }
 
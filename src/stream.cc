@@ -1,14 +1,32 @@
 #include "stream.h"
 
 #include <chrono>
+#include <future>
 #include <iostream>
 #include <sstream>
 #include <utility>
 
+#include "js_frame.h"
+#include "options.h"
 #include "pacheck.h"
+#include "profiler.h"
 
 namespace rtaudio {
-namespace {}  // namespace
+namespace {
+
+PaSampleFormat ToPaSampleFormat(SampleFormat sample_format) {
+  switch (sample_format) {
+    case SampleFormat::kFloat32:
+      return paFloat32;
+    case SampleFormat::kInt16:
+      return paInt16;
+    case SampleFormat::kInt24:
+      return paInt24;
+  }
+  return paFloat32;
+}
+
+}  // namespace
 
 Napi::Function InputStream::GetClass(Napi::Env env) {
   return DefineClass(
@@ -16,6 +34,8 @@ Napi::Function InputStream::GetClass(Napi::Env env) {
       {
           InputStream::InstanceMethod("start", &InputStream::Start),
           InputStream::InstanceMethod("stop", &InputStream::Stop),
+          InputStream::InstanceMethod("getStats", &InputStream::GetStats),
+          InputStream::InstanceMethod("readLatest", &InputStream::ReadLatest),
       });
 }
 
@@ -39,25 +59,62 @@ InputStream::InputStream(const Napi::CallbackInfo& info) : ObjectWrap(info) {
     }
     device_ = value.ToNumber().Int32Value();
   }
-  if (const Napi::Value value = options["sampleRate"]; !value.IsUndefined()) {
+  if (!ParseAudioProcessorOptions(env, options, &processor_options_)) {
+    return;
+  }
+  if (const Napi::Value value = options["schedulingPolicy"];
+      !value.IsUndefined()) {
+    std::optional<SchedulingPolicy> policy;
+    if (value.IsString()) {
+      policy = ParseSchedulingPolicy(value.ToString().Utf8Value());
+    }
+    if (!policy) {
+      NAPI_THROW(Napi::Error::New(
+          env, std::string("Invalid value for schedulingPolicy: ") +
+                   value.ToString().Utf8Value()));
+    }
+    scheduling_policy_ = *policy;
+  }
+  if (const Napi::Value value = options["schedulingPriority"];
+      !value.IsUndefined()) {
     if (!value.IsNumber()) {
+      NAPI_THROW(Napi::Error::New(
+          env, std::string("Invalid value for schedulingPriority: ") +
+                   value.ToString().Utf8Value()));
+    }
+    scheduling_priority_ = value.ToNumber().Int32Value();
+  }
+  if (const Napi::Value value = options["cpuAffinity"]; !value.IsUndefined()) {
+    if (!value.IsArray()) {
       NAPI_THROW(
-          Napi::Error::New(env, std::string("Invalid value for sampleRate: ") +
+          Napi::Error::New(env, std::string("Invalid value for cpuAffinity: ") +
                                     value.ToString().Utf8Value()));
     }
-    sample_rate_ = value.ToNumber().DoubleValue();
-  } else {
-    sample_rate_ = 48000;
+    const Napi::Array cpus = value.As<Napi::Array>();
+    for (uint32_t i = 0; i < cpus.Length(); ++i) {
+      const Napi::Value cpu = cpus.Get(i);
+      if (!cpu.IsNumber()) {
+        NAPI_THROW(Napi::Error::New(
+            env, std::string("Invalid value for cpuAffinity: ") +
+                     value.ToString().Utf8Value()));
+      }
+      cpu_affinity_.push_back(cpu.ToNumber().Int32Value());
+    }
   }
-  if (const Napi::Value value = options["bufferSize"]; !value.IsUndefined()) {
-    if (!value.IsNumber()) {
+  if (const Napi::Value value = options["lockMemory"]; !value.IsUndefined()) {
+    if (!value.IsBoolean()) {
       NAPI_THROW(
-          Napi::Error::New(env, std::string("Invalid value for bufferSize: ") +
+          Napi::Error::New(env, std::string("Invalid value for lockMemory: ") +
                                     value.ToString().Utf8Value()));
     }
-    buffer_size_ = value.ToNumber().Uint32Value();
-  } else {
-    buffer_size_ = 512;
+    lock_memory_ = value.ToBoolean().Value();
+  }
+  if (const Napi::Value value = options["pull"]; !value.IsUndefined()) {
+    if (!value.IsBoolean()) {
+      NAPI_THROW(Napi::Error::New(env, std::string("Invalid value for pull: ") +
+                                           value.ToString().Utf8Value()));
+    }
+    pull_ = value.ToBoolean().Value();
   }
   if (const Napi::Value value = options["callback"]; !value.IsUndefined()) {
     if (!value.IsFunction()) {
@@ -65,32 +122,43 @@ InputStream::InputStream(const Napi::CallbackInfo& info) : ObjectWrap(info) {
           Napi::Error::New(env, std::string("Invalid value for callback: ") +
                                     value.ToString().Utf8Value()));
     }
+    if (pull_) {
+      NAPI_THROW(
+          Napi::Error::New(env, "callback cannot be used with pull: true"));
+    }
     callback_ = Napi::Persistent(value.As<Napi::Function>());
   }
-  frame_ = std::unique_ptr<AudioFrame>(new AudioFrame(buffer_size_));
-  processor_ = CreateAudioProcessor({
-      .buffer_size = buffer_size_,
-      .sample_rate = static_cast<float>(sample_rate_),
-  });
-  Napi::Object frame = Napi::Object::New(env);
-  frame["sampleRate"] = Napi::Number::New(env, sample_rate_);
-  frame["samples"] = Napi::Float32Array::New(env, frame_->samples.size());
-  frame["fft"] = Napi::Float32Array::New(env, frame_->fft.size());
-  frame["absoluteFft"] =
-      Napi::Float32Array::New(env, frame_->absolute_fft.size());
-  for (const auto band_name : {"bass", "mid", "high"}) {
-    Napi::Object band = Napi::Object::New(env);
-    band["samples"] = Napi::Float32Array::New(env, frame_->samples.size());
-    frame[band_name] = band;
-  }
-  js_frame_ = Napi::Persistent(frame);
+  if (const Napi::Value value = options["onTrigger"]; !value.IsUndefined()) {
+    if (!value.IsFunction()) {
+      NAPI_THROW(
+          Napi::Error::New(env, std::string("Invalid value for onTrigger: ") +
+                                    value.ToString().Utf8Value()));
+    }
+    static constexpr size_t kTriggerQueueSize = 256;
+    trigger_callback_ = Napi::Persistent(value.As<Napi::Function>());
+    trigger_queue_.reset(new SpscQueue<TriggerEvent>(kTriggerQueueSize));
+  }
+  // Trigger events only reach JS through onTrigger; frames do not carry them.
+  if (!processor_options_.triggers.empty() && !trigger_queue_) {
+    NAPI_THROW(Napi::Error::New(env, "triggers require an onTrigger callback"));
+  }
+  frame_ = std::unique_ptr<AudioFrame>(new AudioFrame(processor_options_));
+  processor_ = CreateAudioProcessor(
+      processor_options_,
+      [this](const AudioFrame& frame) { DeliverTriggerEvents(frame); });
+  js_frame_ = Napi::Persistent(NewJsFrame(env, processor_options_, *frame_));
 }
 
 InputStream::~InputStream() {
   if (running_) {
     std::cerr << "~InputStream() destructor called while still running."
               << std::endl;
-    tsfn_.Abort();
+    if (!pull_) {
+      tsfn_.Abort();
+    }
+    if (trigger_queue_) {
+      trigger_tsfn_.Abort();
+    }
     Terminate();
   }
   running_ = false;
@@ -142,17 +210,24 @@ void InputStream::Start(const Napi::CallbackInfo& info) {
   const PaStreamParameters inputParameters{
       .device = *device_,
       .channelCount = 1,
-      .sampleFormat = paFloat32,
+      .sampleFormat = ToPaSampleFormat(processor_options_.sample_format),
       .suggestedLatency = inputInfo->defaultLowInputLatency,
   };
-  PA_CHECK(Pa_OpenStream(&stream_, &inputParameters, nullptr, sample_rate_,
-                         buffer_size_, paNoFlag, nullptr, nullptr));
+  PA_CHECK(Pa_OpenStream(&stream_, &inputParameters, nullptr,
+                         processor_options_.sample_rate,
+                         processor_options_.buffer_size, paNoFlag, nullptr,
+                         nullptr));
   PA_CHECK(Pa_StartStream(stream_));
 
   static const char kResourceName[] = "Audio Frame Callback";
   static constexpr size_t kMaxQueueSize = 1;
   static constexpr size_t kInitialThreadCount = 1;
-  if (!callback_.IsEmpty()) {
+  if (pull_) {
+    latest_.reset(new TripleBuffer<PublishedFrame>(
+        PublishedFrame(processor_options_)));
+    failed_ = false;
+    error_ = std::nullopt;
+  } else if (!callback_.IsEmpty()) {
     tsfn_ = TSFN::New(env, callback_.Value().As<Napi::Function>(),
                       kResourceName, kMaxQueueSize, kInitialThreadCount, this);
   } else {
@@ -160,8 +235,47 @@ void InputStream::Start(const Napi::CallbackInfo& info) {
         TSFN::New(env, kResourceName, kMaxQueueSize, kInitialThreadCount, this);
   }
 
+  if (trigger_queue_) {
+    static const char kTriggerResourceName[] = "Audio Trigger Callback";
+    trigger_call_pending_ = false;
+    trigger_tsfn_ = TriggerTSFN::New(
+        env, trigger_callback_.Value().As<Napi::Function>(),
+        kTriggerResourceName, kMaxQueueSize, kInitialThreadCount, this);
+  }
+
+  frame_count_ = 0;
+  overflow_count_ = 0;
+  realtime_ = false;
   running_.store(true);
-  reader_thread_ = std::thread([this, js_this = Napi::Persistent(info.This())] {
+  std::promise<void> prepared;
+  std::future<void> prepared_future = prepared.get_future();
+  reader_thread_ = std::thread([this, &prepared,
+                                js_this = Napi::Persistent(info.This())] {
+    Profiler::SetThreadName("InputStream reader");
+    // Per-thread FFT scratch is allocated and locked here, on the thread
+    // that uses it, so the loop below never allocates.
+    processor_->Prepare();
+    memory_lock_error_ = std::nullopt;
+    if (lock_memory_) {
+      const BufferVisitor lock = [this](const void* data, size_t size) {
+        if (std::optional<std::string> error = memory_lock_.Lock(data, size)) {
+          memory_lock_error_ = std::move(error);
+        }
+      };
+      frame_->VisitBuffers(lock);
+      processor_->VisitBuffers(lock);
+      if (latest_) {
+        latest_->VisitSlots([&lock](const PublishedFrame& published) {
+          published.frame.VisitBuffers(lock);
+        });
+      }
+    }
+    prepared.set_value();
+    // Sleep between polls when running with a real-time policy: a SCHED_FIFO
+    // thread spinning on Pa_GetStreamReadAvailable would starve its core,
+    // including the host API thread that fills the buffer.
+    const auto poll_interval = std::chrono::duration<double>(
+        processor_options_.buffer_size / processor_options_.sample_rate / 4);
     auto last_available = std::chrono::system_clock::now();
     while (running_.load()) {
       auto current_time = std::chrono::system_clock::now();
@@ -171,104 +285,212 @@ void InputStream::Start(const Napi::CallbackInfo& info) {
         std::ostringstream message;
         message << "Error reading stream: " << Pa_GetErrorText(status);
         error_ = message.str();
-        tsfn_.BlockingCall();
+        NotifyError();
         break;
       }
       if (available == 0) {
         auto elapsed = current_time - last_available;
         if (elapsed > std::chrono::seconds(1)) {
           error_ = "Timeout: over 1s waiting for audio";
-          tsfn_.BlockingCall();
+          NotifyError();
           break;
         }
+        if (realtime_.load(std::memory_order_relaxed)) {
+          std::this_thread::sleep_for(poll_interval);
+        }
         continue;
       }
       last_available = current_time;
-      PaError status =
-          Pa_ReadStream(stream_, frame_->samples.data(), buffer_size_);
+      void* const buffer =
+          processor_options_.sample_format == SampleFormat::kFloat32
+              ? static_cast<void*>(frame_->samples.data())
+              : static_cast<void*>(frame_->input.data());
+      PaError status;
+      {
+        ScopedTrace trace("read");
+        status =
+            Pa_ReadStream(stream_, buffer, processor_options_.buffer_size);
+      }
       overflowed_ = false;
       if (status == paInputOverflowed) {
         overflowed_ = true;
+        overflow_count_.fetch_add(1, std::memory_order_relaxed);
         std::cerr << "Input overflowed: " << Pa_GetErrorText(status)
                   << std::endl;
       } else if (status != paNoError) {
         std::ostringstream message;
         message << "Error reading stream: " << Pa_GetErrorText(status);
         error_ = message.str();
-        tsfn_.BlockingCall();
+        NotifyError();
         break;
       }
+      frame_->start_sample = frame_count_.load(std::memory_order_relaxed) *
+                             processor_options_.buffer_size;
       processor_->Process(frame_.get());
+      const uint64_t sequence =
+          frame_count_.fetch_add(1, std::memory_order_relaxed) + 1;
+      if (pull_) {
+        ScopedTrace trace("Publish");
+        PublishedFrame* const published = latest_->back();
+        published->frame = *frame_;
+        published->overflowed = overflowed_;
+        published->sequence = sequence;
+        latest_->Publish();
+        continue;
+      }
+      ScopedTrace trace("BlockingCall");
       tsfn_.BlockingCall();
     }
-    tsfn_.Release();
+    if (!pull_) {
+      tsfn_.Release();
+    }
+    if (trigger_queue_) {
+      trigger_tsfn_.Release();
+    }
     running_ = false;
     if (error_) {
       Terminate();
     }
   });
+  prepared_future.wait();
+  // Capture and processing both run on the reader thread.
+  scheduling_result_ = SetThreadScheduling(
+      reader_thread_, scheduling_policy_, scheduling_priority_);
+  realtime_ = scheduling_result_.policy != SchedulingPolicy::kDefault;
+  affinity_error_ = SetThreadAffinity(reader_thread_, cpu_affinity_);
   cleanup.success = true;
 }
 
-void InputStream::UpdateJsFrame(Napi::Env env) {
-  Napi::Object frame = js_frame_.Value();
-  frame["overflowed"] = Napi::Boolean::New(env, overflowed_);
-  Napi::Float32Array samples = frame.Get("samples").As<Napi::Float32Array>();
-  memcpy(samples.Data(), frame_->samples.data(),
-         sizeof(float) * frame_->samples.size());
-  Napi::Float32Array fft = frame.Get("fft").As<Napi::Float32Array>();
-  memcpy(fft.Data(), frame_->fft.data(), sizeof(float) * frame_->fft.size());
-  Napi::Float32Array absolute_fft =
-      frame.Get("absoluteFft").As<Napi::Float32Array>();
-  memcpy(absolute_fft.Data(), frame_->absolute_fft.data(),
-         sizeof(float) * frame_->absolute_fft.size());
-  frame["rms"] = Napi::Number::New(env, frame_->rms);
-  frame["rmsSlow"] = Napi::Number::New(env, frame_->rms_slow);
-  frame["rmsMid"] = Napi::Number::New(env, frame_->rms_mid);
-  frame["rmsFast"] = Napi::Number::New(env, frame_->rms_fast);
-  frame["normalizedRms"] = Napi::Number::New(env, frame_->normalized_rms);
-  frame["normalizedRmsMid"] =
-      Napi::Number::New(env, frame_->normalized_rms_mid);
-  frame["normalizedRmsFast"] =
-      Napi::Number::New(env, frame_->normalized_rms_fast);
-  frame["peak"] = Napi::Number::New(env, frame_->peak);
-  frame["peakSlow"] = Napi::Number::New(env, frame_->peak_slow);
-  frame["peakMid"] = Napi::Number::New(env, frame_->peak_mid);
-  frame["peakFast"] = Napi::Number::New(env, frame_->peak_fast);
-  frame["normalizedPeak"] = Napi::Number::New(env, frame_->normalized_peak);
-  frame["normalizedPeakMid"] =
-      Napi::Number::New(env, frame_->normalized_peak_mid);
-  frame["normalizedPeakFast"] =
-      Napi::Number::New(env, frame_->normalized_peak_fast);
-  for (auto& [band_name, band] : {
-           std::make_pair("bass", &frame_->bass),
-           std::make_pair("mid", &frame_->mid),
-           std::make_pair("high", &frame_->high),
-       }) {
-    Napi::Object js_band = frame.Get(band_name).As<Napi::Object>();
-    Napi::Float32Array samples =
-        js_band.Get("samples").As<Napi::Float32Array>();
-    memcpy(samples.Data(), band->samples.data(),
-           sizeof(float) * band->samples.size());
-    js_band["rms"] = Napi::Number::New(env, band->rms);
-    js_band["rmsSlow"] = Napi::Number::New(env, band->rms_slow);
-    js_band["rmsMid"] = Napi::Number::New(env, band->rms_mid);
-    js_band["rmsFast"] = Napi::Number::New(env, band->rms_fast);
-    js_band["normalizedRms"] = Napi::Number::New(env, band->normalized_rms);
-    js_band["normalizedRmsMid"] =
-        Napi::Number::New(env, band->normalized_rms_mid);
-    js_band["normalizedRmsFast"] =
-        Napi::Number::New(env, band->normalized_rms_fast);
-    js_band["peak"] = Napi::Number::New(env, band->peak);
-    js_band["peakSlow"] = Napi::Number::New(env, band->peak_slow);
-    js_band["peakMid"] = Napi::Number::New(env, band->peak_mid);
-    js_band["peakFast"] = Napi::Number::New(env, band->peak_fast);
-    js_band["normalizedPeak"] = Napi::Number::New(env, band->normalized_peak);
-    js_band["normalizedPeakMid"] =
-        Napi::Number::New(env, band->normalized_peak_mid);
-    js_band["normalizedPeakFast"] =
-        Napi::Number::New(env, band->normalized_peak_fast);
+Napi::Value InputStream::GetStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Object stats = Napi::Object::New(env);
+  stats["frames"] =
+      Napi::Number::New(env, static_cast<double>(frame_count_.load()));
+  stats["overflows"] =
+      Napi::Number::New(env, static_cast<double>(overflow_count_.load()));
+  stats["sampleRate"] = Napi::Number::New(env, processor_options_.sample_rate);
+  stats["bufferSize"] = Napi::Number::New(env, processor_options_.buffer_size);
+  stats["sampleFormat"] = GetSampleFormatName(processor_options_.sample_format);
+  stats["droppedTriggerEvents"] = Napi::Number::New(
+      env, static_cast<double>(dropped_trigger_events_.load()));
+
+  Napi::Object scheduling = Napi::Object::New(env);
+  scheduling["requestedPolicy"] = GetSchedulingPolicyName(scheduling_policy_);
+  scheduling["requestedPriority"] =
+      Napi::Number::New(env, scheduling_priority_);
+  scheduling["policy"] = GetSchedulingPolicyName(scheduling_result_.policy);
+  scheduling["priority"] = Napi::Number::New(env, scheduling_result_.priority);
+  if (scheduling_result_.error) {
+    scheduling["error"] = *scheduling_result_.error;
+  }
+  stats["scheduling"] = scheduling;
+
+  Napi::Object affinity = Napi::Object::New(env);
+  Napi::Array cpus = Napi::Array::New(env, cpu_affinity_.size());
+  for (size_t i = 0; i < cpu_affinity_.size(); ++i) {
+    cpus[i] = Napi::Number::New(env, cpu_affinity_[i]);
+  }
+  affinity["cpus"] = cpus;
+  if (affinity_error_) {
+    affinity["error"] = *affinity_error_;
+  }
+  stats["affinity"] = affinity;
+
+  Napi::Object memory = Napi::Object::New(env);
+  memory["locked"] = Napi::Boolean::New(
+      env, lock_memory_ && memory_lock_.locked_bytes() > 0);
+  memory["lockedBytes"] = Napi::Number::New(
+      env, static_cast<double>(memory_lock_.locked_bytes()));
+  if (memory_lock_error_) {
+    memory["error"] = *memory_lock_error_;
+  }
+  stats["memory"] = memory;
+  return stats;
+}
+
+void InputStream::UpdateJsFrame(Napi::Env env, const AudioFrame& frame,
+                                bool overflowed) {
+  ScopedTrace trace("UpdateJsFrame");
+  Napi::Object js_frame = js_frame_.Value();
+  js_frame["overflowed"] = Napi::Boolean::New(env, overflowed);
+  rtaudio::UpdateJsFrame(env, processor_options_, frame, js_frame);
+}
+
+void InputStream::DeliverTriggerEvents(const AudioFrame& frame) {
+  dropped_trigger_events_.fetch_add(frame.dropped_trigger_events,
+                                    std::memory_order_relaxed);
+  if (!trigger_queue_ || frame.trigger_event_count == 0) {
+    return;
+  }
+  for (size_t i = 0; i < frame.trigger_event_count; ++i) {
+    if (!trigger_queue_->Push(frame.trigger_events[i])) {
+      dropped_trigger_events_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  if (!trigger_call_pending_.exchange(true)) {
+    if (trigger_tsfn_.NonBlockingCall() != napi_ok) {
+      trigger_call_pending_ = false;
+    }
+  }
+}
+
+void InputStream::CallTriggerJs(Napi::Env env, Napi::Function callback,
+                                InputStream* stream, void* data) {
+  if (env == nullptr || callback == nullptr) {
+    return;
+  }
+  ScopedTrace trace("CallTriggerJs");
+  // Cleared first, so events queued while draining schedule another call.
+  stream->trigger_call_pending_ = false;
+  const AudioProcessorOptions& options = stream->processor_options_;
+  TriggerEvent event;
+  while (stream->trigger_queue_->Pop(&event)) {
+    Napi::Object js_event = Napi::Object::New(env);
+    js_event["trigger"] = options.triggers[event.trigger].name;
+    js_event["index"] = Napi::Number::New(env, event.trigger);
+    js_event["type"] = event.on ? "on" : "off";
+    js_event["sample"] =
+        Napi::Number::New(env, static_cast<double>(event.sample));
+    js_event["time"] = Napi::Number::New(
+        env, static_cast<double>(event.sample) / options.sample_rate);
+    js_event["level"] = Napi::Number::New(env, event.level);
+    callback.Call({js_event});
+  }
+}
+
+void InputStream::NotifyError() {
+  if (pull_) {
+    failed_.store(true, std::memory_order_release);
+  } else {
+    tsfn_.BlockingCall();
+  }
+}
+
+Napi::Value InputStream::ReadLatest(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!pull_) {
+    NAPI_THROW(Napi::Error::New(env, "readLatest() requires pull: true"),
+               env.Null());
+  }
+  // The reader thread has exited or is about to, and no longer writes
+  // `error_`. It is cleared by the next Start().
+  if (failed_.exchange(false, std::memory_order_acquire)) {
+    NAPI_THROW(Napi::Error::New(env, error_.value_or("Unknown error")),
+               env.Null());
+  }
+  if (!latest_) {
+    return env.Null();
+  }
+  if (latest_->Update()) {
+    const PublishedFrame& published = latest_->front();
+    UpdateJsFrame(env, published.frame, published.overflowed);
+    js_frame_.Value()["sequence"] = Napi::Number::New(
+        env, static_cast<double>(published.sequence));
   }
+  if (latest_->front().sequence == 0) {
+    return env.Null();
+  }
+  return js_frame_.Value();
 }
 
 void InputStream::CallJs(Napi::Env env, Napi::Function callback,
@@ -276,7 +498,8 @@ void InputStream::CallJs(Napi::Env env, Napi::Function callback,
   if (env == nullptr || callback == nullptr) {
     return;
   }
-  stream->UpdateJsFrame(env);
+  ScopedTrace trace("CallJs");
+  stream->UpdateJsFrame(env, *stream->frame_, stream->overflowed_);
   if (!stream->error_) {
     Napi::Object frame = stream->js_frame_.Value();
     callback.Call({env.Undefined(), frame});
@@ -301,12 +524,19 @@ void InputStream::Stop(const Napi::CallbackInfo& info) {
   if (!reader_thread_.joinable()) {
     NAPI_THROW(Napi::Error::New(env, "Reader thread not running"));
   }
-  tsfn_.Abort();
+  if (!pull_) {
+    tsfn_.Abort();
+  }
+  if (trigger_queue_) {
+    trigger_tsfn_.Abort();
+  }
 
   running_.store(false);
   reader_thread_.join();
   reader_thread_ = std::thread();
 
+  memory_lock_.Unlock();
+
   PA_CHECK(Pa_StopStream(stream_));
   stream_ = nullptr;
   Terminate();
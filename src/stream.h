@@ -5,11 +5,16 @@
 #include <portaudio.h>
 
 #include <atomic>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <thread>
+#include <vector>
 
 #include "audio.h"
+#include "realtime.h"
+#include "spsc_queue.h"
+#include "triple_buffer.h"
 
 namespace rtaudio {
 
@@ -23,24 +28,77 @@ class InputStream : public Napi::ObjectWrap<InputStream> {
 
   void Stop(const Napi::CallbackInfo&);
 
+  Napi::Value GetStats(const Napi::CallbackInfo&);
+
+  // Pull mode only. Returns the newest processed frame, or null before the
+  // first one. The same object is returned each time and is only rewritten
+  // when a newer frame exists; its `sequence` tells frames apart.
+  Napi::Value ReadLatest(const Napi::CallbackInfo&);
+
  private:
+  // A processed frame as handed to JS in pull mode.
+  struct PublishedFrame {
+    explicit PublishedFrame(const AudioProcessorOptions& options)
+        : frame(options) {}
+
+    AudioFrame frame;
+    bool overflowed = false;
+    uint64_t sequence = 0;
+  };
+
   static void CallJs(Napi::Env env, Napi::Function callback,
                      InputStream* stream, void* data);
-  void UpdateJsFrame(Napi::Env env);
+  static void CallTriggerJs(Napi::Env env, Napi::Function callback,
+                            InputStream* stream, void* data);
+  // Queues `frame`'s trigger events for `trigger_tsfn_`. Called on the reader
+  // thread straight after the trigger stage, before the rest of the chain.
+  void DeliverTriggerEvents(const AudioFrame& frame);
+  void UpdateJsFrame(Napi::Env env, const AudioFrame& frame, bool overflowed);
+  // Hands `error_` to JS: through the callback in push mode, or to the next
+  // ReadLatest() call in pull mode.
+  void NotifyError();
   static void Terminate();
 
   PaStream* stream_ = nullptr;
   std::atomic<bool> running_{false};
   std::optional<int> device_;
-  double sample_rate_;
-  unsigned long buffer_size_;
+  AudioProcessorOptions processor_options_;
   bool overflowed_;
   std::unique_ptr<AudioFrame> frame_;
   std::unique_ptr<AudioProcessor> processor_;
   std::thread reader_thread_;
 
+  SchedulingPolicy scheduling_policy_ = SchedulingPolicy::kDefault;
+  int scheduling_priority_ = 0;
+  std::vector<int> cpu_affinity_;
+  bool lock_memory_ = false;
+  SchedulingResult scheduling_result_;
+  std::atomic<bool> realtime_{false};
+  std::optional<std::string> affinity_error_;
+  MemoryLock memory_lock_;
+  std::optional<std::string> memory_lock_error_;
+  std::atomic<uint64_t> frame_count_{0};
+  std::atomic<uint64_t> overflow_count_{0};
+
   using TSFN = Napi::TypedThreadSafeFunction<InputStream, void, CallJs>;
 
+  // In pull mode frames are published here instead of being pushed through
+  // `tsfn_`, which is then never created.
+  bool pull_ = false;
+  std::unique_ptr<TripleBuffer<PublishedFrame>> latest_;
+  std::atomic<bool> failed_{false};
+
+  using TriggerTSFN =
+      Napi::TypedThreadSafeFunction<InputStream, void, CallTriggerJs>;
+
+  // Only set up when an onTrigger callback was given. At most one call is
+  // queued at a time; it drains every event queued so far.
+  std::unique_ptr<SpscQueue<TriggerEvent>> trigger_queue_;
+  std::atomic<bool> trigger_call_pending_{false};
+  std::atomic<uint64_t> dropped_trigger_events_{0};
+  TriggerTSFN trigger_tsfn_;
+  Napi::FunctionReference trigger_callback_;
+
   TSFN tsfn_;
   Napi::FunctionReference callback_;
   std::optional<std::string> error_;
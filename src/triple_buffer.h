@@ -0,0 +1,64 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace rtaudio {
+
+// Hands the newest value from one producer thread to one consumer thread
+// without locks. Each side owns one of three slots and the third is swapped
+// through a single atomic, so neither side ever waits for the other and the
+// consumer only ever sees completely written values. Values the consumer does
+// not get to in time are overwritten.
+template <typename T>
+class TripleBuffer {
+ public:
+  explicit TripleBuffer(const T& initial)
+      : slots_{initial, initial, initial} {}
+  TripleBuffer(const TripleBuffer&) = delete;
+  TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+  // Producer side: fill in back(), then Publish() it.
+  T* back() { return &slots_[back_]; }
+  void Publish() {
+    back_ = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel) &
+            kIndexMask;
+  }
+
+  // Consumer side: makes the most recently published value current and
+  // returns true, or returns false if nothing was published since the last
+  // call.
+  bool Update() {
+    if (!(middle_.load(std::memory_order_relaxed) & kFresh)) {
+      return false;
+    }
+    front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+    return true;
+  }
+  const T& front() const { return slots_[front_]; }
+
+  // Calls `visit(slot)` on all three slots, for setup such as memory locking.
+  // Not safe while either side is running.
+  template <typename Visit>
+  void VisitSlots(const Visit& visit) const {
+    for (const T& slot : slots_) {
+      visit(slot);
+    }
+  }
+
+ private:
+  static constexpr uint8_t kIndexMask = 3;
+  // Set while the middle slot holds a value the consumer has not taken.
+  static constexpr uint8_t kFresh = 4;
+
+  std::array<T, 3> slots_;
+  uint8_t back_ = 0;
+  std::atomic<uint8_t> middle_{1};
+  uint8_t front_ = 2;
+};
+
+}  // namespace rtaudio
+
+#endif  // TRIPLE_BUFFER_H